@@ -1,8 +1,12 @@
 from contextlib import suppress
 import esphome.codegen as cg
 import esphome.config_validation as cv
+import esphome.final_validate as fv
 from esphome import pins, automation
 from esphome.components import spi
+from esphome.components.esp32 import add_idf_component, get_esp32_variant
+from esphome.components.esp32.const import VARIANT_ESP32, VARIANT_ESP32P4, VARIANT_ESP32S3
+from esphome.core import CORE, ID
 from esphome.cpp_generator import LambdaExpression
 from esphome.const import (
     CONF_ID,
@@ -28,6 +32,12 @@ CONF_RADIO_ID = "radio_id"
 CONF_ON_FRAME = "on_frame"
 CONF_RADIO_TYPE = "radio_type"
 CONF_MARK_AS_HANDLED = "mark_as_handled"
+# on_frame pre-filters
+CONF_LINK_MODE = "link_mode"
+CONF_MIN_RSSI = "min_rssi"
+CONF_MANUFACTURER = "manufacturer"
+CONF_METER_ID = "meter_id"
+CONF_CI = "ci"
 CONF_BUSY_PIN = "busy_pin"
 
 # SX1262 board helpers
@@ -44,6 +54,72 @@ CONF_DIAG_VERBOSE = "diagnostic_verbose"
 CONF_DIAG_PUBLISH_RAW = "diagnostic_publish_raw"
 CONF_DIAG_SUMMARY_INTERVAL = "diagnostic_summary_interval"
 
+# Packet queue between receiver task and main loop
+CONF_QUEUE_DEPTH = "queue_depth"
+CONF_QUEUE_IN_PSRAM = "queue_in_psram"
+CONF_QUEUE_OVERFLOW = "queue_overflow"
+
+# Outbound MQTT queue drained by the main loop
+CONF_PUBLISH_QUEUE = "publish_queue"
+CONF_TELEGRAMS = "telegrams"
+CONF_DIAGNOSTICS = "diagnostics"
+CONF_LOOP_BUDGET = "loop_budget"
+
+# Alarms and installation requests published ahead of everything else
+CONF_PRIORITY_LANE = "priority_lane"
+CONF_STATUS_MASK = "status_mask"
+
+# Keep telegrams while the broker is unreachable and replay them after
+CONF_STORE_FORWARD = "store_forward"
+CONF_RAM_SIZE = "ram_size"
+CONF_IN_PSRAM = "in_psram"
+CONF_REPLAY_RATE = "replay_rate"
+CONF_FLASH_SPILL = "flash_spill"
+CONF_PARTITION = "partition"
+CONF_MAX_SIZE = "max_size"
+
+# FreeRTOS tasks: receiver and the optional processing task (decodes
+# packets ahead of the main loop)
+CONF_RECEIVER_TASK = "receiver_task"
+CONF_PROCESSING_TASK = "processing_task"
+CONF_CORE = "core"
+CONF_PRIORITY = "priority"
+CONF_STACK_SIZE = "stack_size"
+
+# Built-in publishing of received telegrams
+CONF_TELEGRAM_TOPIC = "telegram_topic"
+CONF_TELEGRAM_FORMAT = "telegram_format"
+CONF_TELEGRAM_BATCH = "telegram_batch"
+CONF_TELEGRAM_TOPIC_PER_METER = "telegram_topic_per_meter"
+CONF_MAX_DELAY = "max_delay"
+CONF_MAX_BYTES = "max_bytes"
+CONF_TELEGRAM_DELTA = "telegram_delta"
+CONF_METERS = "meters"
+CONF_KEYFRAME_INTERVAL = "keyframe_interval"
+
+# Duplicate suppression
+CONF_DEDUP = "dedup"
+CONF_WINDOW = "window"
+CONF_CACHE_SIZE = "cache_size"
+
+# Meter allow/deny list
+CONF_ADDRESS_FILTER = "address_filter"
+CONF_MODE = "mode"
+CONF_ADDRESSES = "addresses"
+
+# Per-meter publish policy
+CONF_PUBLISH_POLICY = "publish_policy"
+CONF_ADDRESS = "address"
+CONF_MIN_INTERVAL = "min_interval"
+CONF_ON_CHANGE_ONLY = "on_change_only"
+CONF_HEARTBEAT = "heartbeat"
+
+# Per-meter reception statistics
+CONF_METER_STATS = "meter_stats"
+CONF_CAPACITY = "capacity"
+CONF_TOPIC = "topic"
+CONF_PAGE_SIZE = "page_size"
+
 # Heltec V4 FEM pins (SX1262 external front-end)
 CONF_FEM_CTRL_PIN = "fem_ctrl_pin"
 CONF_FEM_EN_PIN = "fem_en_pin"
@@ -52,10 +128,36 @@ CONF_FEM_PA_PIN = "fem_pa_pin"
 radio_ns = cg.esphome_ns.namespace("wmbus_radio")
 RadioComponent = radio_ns.class_("Radio", cg.Component)
 RadioTransceiver = radio_ns.class_("RadioTransceiver", spi.SPIDevice, cg.Component)
+DedupCache = radio_ns.class_("DedupCache")
+AddressFilter = radio_ns.class_("AddressFilter")
+AddressFilterMode = AddressFilter.enum("Mode")
+PacketPool = radio_ns.class_("PacketPool")
+PacketPoolOverflowPolicy = PacketPool.enum("OverflowPolicy")
+QUEUE_OVERFLOW_POLICIES = {
+    "drop_newest": PacketPoolOverflowPolicy.OVERFLOW_DROP_NEWEST,
+    "drop_oldest": PacketPoolOverflowPolicy.OVERFLOW_DROP_OLDEST,
+    "drop_lowest_rssi": PacketPoolOverflowPolicy.OVERFLOW_DROP_LOWEST_RSSI,
+}
+ADDRESS_FILTER_MODES = {
+    "allow": AddressFilterMode.MODE_ALLOW,
+    "deny": AddressFilterMode.MODE_DENY,
+}
 Frame = radio_ns.class_("Frame")
 FrameOutputFormat = Frame.enum("OutputFormat")
+TELEGRAM_FORMATS = {
+    "hex": FrameOutputFormat.FORMAT_HEX,
+    "rtlwmbus": FrameOutputFormat.FORMAT_RTLWMBUS,
+    "binary": FrameOutputFormat.FORMAT_BINARY,
+    "cbor": FrameOutputFormat.FORMAT_CBOR,
+    "delta": FrameOutputFormat.FORMAT_DELTA,
+}
 FramePtr = Frame.operator("ptr")
 FrameTrigger = radio_ns.class_("FrameTrigger", automation.Trigger.template(FramePtr))
+LinkMode = radio_ns.enum("LinkMode", is_class=True)
+LINK_MODES = {
+    "T1": LinkMode.T1,
+    "C1": LinkMode.C1,
+}
 
 TRANSCEIVER_NAMES = {
     r.stem.removeprefix("transceiver_").upper()
@@ -63,7 +165,77 @@ TRANSCEIVER_NAMES = {
     if r.is_file()
 }
 
-CONFIG_SCHEMA = (
+def manufacturer_code(value):
+    """'KAM' -> M-field value."""
+    letters = cv.string_strict(value).strip().upper()
+    if len(letters) != 3 or not all("A" <= c <= "Z" for c in letters):
+        raise cv.Invalid(f"Invalid manufacturer code '{value}'")
+    manufacturer = 0
+    for c in letters:
+        manufacturer = (manufacturer << 5) | (ord(c) - 64)
+    return manufacturer
+
+
+def meter_address(value):
+    """'12345678' (any manufacturer) or 'KAM:12345678' -> (manufacturer, id)."""
+    value = cv.string_strict(value).strip()
+    manufacturer = 0
+    if len(value) == 12 and value[3] == ":":
+        manufacturer = manufacturer_code(value[:3])
+        value = value[4:]
+    if len(value) != 8:
+        raise cv.Invalid("Meter address must be 8 digits, optionally prefixed with 'MFT:'")
+    try:
+        meter_id = int(value, 16)
+    except ValueError as err:
+        raise cv.Invalid(f"Invalid meter ID '{value}'") from err
+    return manufacturer, meter_id
+
+
+def meter_id_pattern(value):
+    """'1234****' (* or ? for any digit) -> (value, mask)."""
+    value = cv.string_strict(value).strip()
+    if len(value) != 8:
+        raise cv.Invalid("Meter ID pattern must be 8 characters, e.g. '1234****'")
+    pattern = 0
+    mask = 0
+    for c in value:
+        pattern <<= 4
+        mask <<= 4
+        if c in "*?":
+            continue
+        if c not in "0123456789abcdefABCDEF":
+            raise cv.Invalid(f"Invalid character '{c}' in meter ID pattern")
+        pattern |= int(c, 16)
+        mask |= 0xF
+    return pattern, mask
+
+
+# No core: the scheduler picks one
+TASK_SCHEMA = cv.Schema(
+    {
+        cv.Optional(CONF_CORE): cv.int_range(min=0, max=1),
+        cv.Optional(CONF_PRIORITY, default=2): cv.int_range(min=1, max=24),
+        cv.Optional(CONF_STACK_SIZE, default=3072): cv.int_range(min=2048, max=16384),
+    }
+)
+
+
+def _validate_telegram_publishing(config):
+    if CONF_TELEGRAM_BATCH in config and CONF_TELEGRAM_TOPIC not in config:
+        raise cv.Invalid(f"{CONF_TELEGRAM_BATCH} requires {CONF_TELEGRAM_TOPIC}")
+    # Without a topic nothing goes out early, and skipping dedup would only
+    # hand duplicate alarms to the on_frame handlers
+    if CONF_PRIORITY_LANE in config and CONF_TELEGRAM_TOPIC not in config:
+        raise cv.Invalid(f"{CONF_PRIORITY_LANE} requires {CONF_TELEGRAM_TOPIC}")
+    if CONF_TELEGRAM_BATCH in config and config[CONF_TELEGRAM_TOPIC_PER_METER]:
+        raise cv.Invalid(
+            f"{CONF_TELEGRAM_BATCH} can't be combined with {CONF_TELEGRAM_TOPIC_PER_METER}"
+        )
+    return config
+
+
+CONFIG_SCHEMA = cv.All(
     cv.Schema(
         {
             cv.GenerateID(): cv.declare_id(RadioComponent),
@@ -90,6 +262,12 @@ CONFIG_SCHEMA = (
                 {
                     cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(FrameTrigger),
                     cv.Optional(CONF_MARK_AS_HANDLED, default=False): cv.boolean,
+                    # Checked before the automation runs
+                    cv.Optional(CONF_LINK_MODE): cv.enum(LINK_MODES, upper=True),
+                    cv.Optional(CONF_MIN_RSSI): cv.int_range(min=-128, max=0),
+                    cv.Optional(CONF_MANUFACTURER): manufacturer_code,
+                    cv.Optional(CONF_METER_ID): meter_id_pattern,
+                    cv.Optional(CONF_CI): cv.ensure_list(cv.hex_uint8_t),
                 }
             ),
 
@@ -100,13 +278,156 @@ CONFIG_SCHEMA = (
             cv.Optional(CONF_DIAG_VERBOSE, default=True): cv.boolean,
             cv.Optional(CONF_DIAG_PUBLISH_RAW, default=True): cv.boolean,
             cv.Optional(CONF_DIAG_SUMMARY_INTERVAL, default="60s"): cv.positive_time_period_milliseconds,
+
+            # Preallocated packets (each ~0.5 kB); PSRAM is used if available
+            cv.Optional(CONF_QUEUE_DEPTH, default=8): cv.int_range(min=2, max=64),
+            cv.Optional(CONF_QUEUE_IN_PSRAM, default=False): cv.boolean,
+            # What to drop when all packets are in use
+            cv.Optional(CONF_QUEUE_OVERFLOW, default="drop_newest"): cv.enum(
+                QUEUE_OVERFLOW_POLICIES, lower=True
+            ),
+            cv.Optional(CONF_RECEIVER_TASK, default={}): TASK_SCHEMA,
+            # Decode in a separate task; loop() then handles all decoded packets at once
+            cv.Optional(CONF_PROCESSING_TASK): TASK_SCHEMA,
+
+            # Publish from a bounded queue instead of inside frame processing
+            cv.Optional(CONF_PUBLISH_QUEUE): cv.Schema(
+                {
+                    cv.Optional(CONF_TELEGRAMS, default=16): cv.int_range(min=1, max=256),
+                    cv.Optional(CONF_DIAGNOSTICS, default=4): cv.int_range(min=1, max=64),
+                    cv.Optional(CONF_LOOP_BUDGET, default="5ms"): cv.positive_time_period_microseconds,
+                }
+            ),
+
+            # CI 0x71 alarms, SND_IR installation requests and TPL status bits:
+            # no dedup or publish policy, published before the on_frame handlers
+            cv.Optional(CONF_PRIORITY_LANE): cv.Schema(
+                {
+                    # Power low, permanent error, temporary error
+                    cv.Optional(CONF_STATUS_MASK, default=0x1C): cv.hex_uint8_t,
+                }
+            ),
+
+            # Keep telegrams in RAM (and optionally on flash) while MQTT is down
+            cv.Optional(CONF_STORE_FORWARD): cv.Schema(
+                {
+                    cv.Optional(CONF_RAM_SIZE, default="32KB"): cv.All(
+                        cv.validate_bytes, cv.int_range(min=1024, max=4 * 1024 * 1024)
+                    ),
+                    cv.Optional(CONF_IN_PSRAM, default=True): cv.boolean,
+                    # Telegrams per second replayed once the broker is back
+                    cv.Optional(CONF_REPLAY_RATE, default=10): cv.int_range(min=1, max=1000),
+                    # Log file on a LittleFS data partition, used once RAM is full
+                    cv.Optional(CONF_FLASH_SPILL): cv.Schema(
+                        {
+                            cv.Optional(CONF_PARTITION, default="spool"): cv.string_strict,
+                            cv.Optional(CONF_MAX_SIZE, default="256KB"): cv.All(
+                                cv.validate_bytes, cv.int_range(min=4096)
+                            ),
+                        }
+                    ),
+                }
+            ),
+
+            # Publish every received frame without an on_frame automation
+            cv.Optional(CONF_TELEGRAM_TOPIC): cv.publish_topic,
+            cv.Optional(CONF_TELEGRAM_FORMAT, default="hex"): cv.enum(
+                TELEGRAM_FORMATS, lower=True
+            ),
+            # <telegram_topic>/<manufacturer>/<id>, e.g. wmbus_bridge/telegram/KAM/12345678
+            cv.Optional(CONF_TELEGRAM_TOPIC_PER_METER, default=False): cv.boolean,
+            # State for telegram_format: delta
+            cv.Optional(CONF_TELEGRAM_DELTA, default={}): cv.Schema(
+                {
+                    cv.Optional(CONF_METERS, default=32): cv.int_range(min=1, max=256),
+                    cv.Optional(CONF_KEYFRAME_INTERVAL, default=10): cv.int_range(min=1, max=255),
+                }
+            ),
+            # Collect frames and publish them as one message
+            cv.Optional(CONF_TELEGRAM_BATCH): cv.Schema(
+                {
+                    cv.Optional(CONF_MAX_DELAY, default="1s"): cv.positive_time_period_milliseconds,
+                    cv.Optional(CONF_MAX_BYTES, default=1024): cv.int_range(min=128, max=16384),
+                }
+            ),
+
+            # Only (allow) or all but (deny) the listed meters
+            cv.Optional(CONF_ADDRESS_FILTER): cv.Schema(
+                {
+                    cv.Required(CONF_MODE): cv.enum(ADDRESS_FILTER_MODES, lower=True),
+                    cv.Optional(CONF_ADDRESSES, default=[]): cv.ensure_list(meter_address),
+                }
+            ),
+
+            # Rate limits for chatty meters
+            cv.Optional(CONF_PUBLISH_POLICY): cv.ensure_list(
+                cv.Schema(
+                    {
+                        cv.Required(CONF_ADDRESS): meter_address,
+                        cv.Optional(CONF_MIN_INTERVAL, default="0s"): cv.positive_time_period_milliseconds,
+                        cv.Optional(CONF_ON_CHANGE_ONLY, default=False): cv.boolean,
+                        cv.Optional(CONF_HEARTBEAT, default="0s"): cv.positive_time_period_milliseconds,
+                    }
+                )
+            ),
+
+            # Statistics per meter, published on request to <topic>/get
+            cv.Optional(CONF_METER_STATS): cv.Schema(
+                {
+                    cv.Optional(CONF_CAPACITY, default=512): cv.int_range(min=16, max=4096),
+                    cv.Optional(CONF_TOPIC, default="wmbus/meters"): cv.publish_topic,
+                    cv.Optional(CONF_PAGE_SIZE, default=10): cv.int_range(min=1, max=50),
+                }
+            ),
+
+            # Suppress repeated telegrams (one cache for all radios)
+            cv.Optional(CONF_DEDUP): cv.Schema(
+                {
+                    cv.Optional(CONF_WINDOW, default="10s"): cv.positive_time_period_milliseconds,
+                    cv.Optional(CONF_CACHE_SIZE, default=128): cv.int_range(min=8, max=1024),
+                }
+            ),
         }
     )
     .extend(spi.spi_device_schema())
-    .extend(cv.COMPONENT_SCHEMA)
+    .extend(cv.COMPONENT_SCHEMA),
+    _validate_telegram_publishing,
 )
 
 
+def _final_validate_dedup(config):
+    # One cache serves all radios, so they have to agree on its settings
+    if CONF_DEDUP not in config:
+        return config
+    for other in fv.full_config.get().get("wmbus_radio", []):
+        if CONF_DEDUP in other and other[CONF_DEDUP] != config[CONF_DEDUP]:
+            raise cv.Invalid(
+                "All radios share one dedup cache: window and cache_size must match",
+                path=[CONF_DEDUP],
+            )
+    return config
+
+
+# The others (S2, C3, C6, H2, ...) have a single core
+DUAL_CORE_VARIANTS = (VARIANT_ESP32, VARIANT_ESP32S3, VARIANT_ESP32P4)
+
+
+def _final_validate_task_cores(config):
+    variant = get_esp32_variant()
+    if variant in DUAL_CORE_VARIANTS:
+        return config
+    for key in (CONF_RECEIVER_TASK, CONF_PROCESSING_TASK):
+        if config.get(key, {}).get(CONF_CORE, 0) != 0:
+            raise cv.Invalid(
+                f"{variant} has a single core: use core 0 or leave it unset",
+                path=[key, CONF_CORE],
+            )
+    return config
+
+
+FINAL_VALIDATE_SCHEMA = cv.All(_final_validate_dedup, _final_validate_task_cores)
+
+
 async def to_code(config):
     cg.add(cg.LineComment("WMBus RadioTransceiver"))
 
@@ -164,12 +485,108 @@ async def to_code(config):
     cg.add(var.set_diag_publish_raw(config.get(CONF_DIAG_PUBLISH_RAW, True)))
     cg.add(var.set_diag_summary_interval_ms(config[CONF_DIAG_SUMMARY_INTERVAL].total_milliseconds))
 
+    cg.add(var.set_queue_depth(config[CONF_QUEUE_DEPTH]))
+    cg.add(var.set_queue_in_psram(config[CONF_QUEUE_IN_PSRAM]))
+    cg.add(var.set_queue_overflow(config[CONF_QUEUE_OVERFLOW]))
+    task = config[CONF_RECEIVER_TASK]
+    cg.add(var.set_receiver_task(task.get(CONF_CORE, -1), task[CONF_PRIORITY], task[CONF_STACK_SIZE]))
+    if CONF_PROCESSING_TASK in config:
+        task = config[CONF_PROCESSING_TASK]
+        cg.add(var.set_processing_task(task.get(CONF_CORE, -1), task[CONF_PRIORITY], task[CONF_STACK_SIZE]))
+
+    if CONF_PUBLISH_QUEUE in config:
+        queue = config[CONF_PUBLISH_QUEUE]
+        cg.add(
+            var.set_publish_queue(
+                queue[CONF_TELEGRAMS],
+                queue[CONF_DIAGNOSTICS],
+                queue[CONF_LOOP_BUDGET].total_microseconds,
+            )
+        )
+
+    if CONF_PRIORITY_LANE in config:
+        cg.add(var.set_priority_lane(config[CONF_PRIORITY_LANE][CONF_STATUS_MASK]))
+
+    if CONF_STORE_FORWARD in config:
+        store = config[CONF_STORE_FORWARD]
+        cg.add(
+            var.set_store_forward(
+                store[CONF_RAM_SIZE], store[CONF_IN_PSRAM], store[CONF_REPLAY_RATE]
+            )
+        )
+        if CONF_FLASH_SPILL in store:
+            spill = store[CONF_FLASH_SPILL]
+            cg.add(var.set_store_forward_flash(spill[CONF_PARTITION], spill[CONF_MAX_SIZE]))
+            cg.add_define("USE_WMBUS_LITTLEFS")
+            add_idf_component(name="joltwallet/littlefs", ref="1.14.8")
+
+    if CONF_TELEGRAM_TOPIC in config:
+        cg.add(var.set_telegram_topic(config[CONF_TELEGRAM_TOPIC]))
+        cg.add(var.set_telegram_format(config[CONF_TELEGRAM_FORMAT]))
+        cg.add(var.set_telegram_topic_per_meter(config[CONF_TELEGRAM_TOPIC_PER_METER]))
+        if config[CONF_TELEGRAM_FORMAT] == "delta":
+            delta = config[CONF_TELEGRAM_DELTA]
+            cg.add(var.set_telegram_delta(delta[CONF_METERS], delta[CONF_KEYFRAME_INTERVAL]))
+        if CONF_TELEGRAM_BATCH in config:
+            batch = config[CONF_TELEGRAM_BATCH]
+            cg.add(
+                var.set_telegram_batch(
+                    batch[CONF_MAX_DELAY].total_milliseconds, batch[CONF_MAX_BYTES]
+                )
+            )
+
+    if CONF_ADDRESS_FILTER in config:
+        address_filter = config[CONF_ADDRESS_FILTER]
+        cg.add(var.set_address_filter_mode(address_filter[CONF_MODE]))
+        for manufacturer, meter_id in address_filter[CONF_ADDRESSES]:
+            cg.add(var.add_filter_address(manufacturer, meter_id))
+
+    for policy in config.get(CONF_PUBLISH_POLICY, []):
+        manufacturer, meter_id = policy[CONF_ADDRESS]
+        cg.add(
+            var.add_publish_policy(
+                manufacturer,
+                meter_id,
+                policy[CONF_MIN_INTERVAL].total_milliseconds,
+                policy[CONF_ON_CHANGE_ONLY],
+                policy[CONF_HEARTBEAT].total_milliseconds,
+            )
+        )
+
+    if CONF_METER_STATS in config:
+        meter_stats = config[CONF_METER_STATS]
+        cg.add(var.set_meter_stats_capacity(meter_stats[CONF_CAPACITY]))
+        cg.add(var.set_meter_stats_topic(meter_stats[CONF_TOPIC]))
+        cg.add(var.set_meter_stats_page_size(meter_stats[CONF_PAGE_SIZE]))
+
+    if CONF_DEDUP in config:
+        # Created by the first radio that enables it, shared by the others
+        data = CORE.data.setdefault("wmbus_radio", {})
+        if "dedup_cache" not in data:
+            dedup = config[CONF_DEDUP]
+            data["dedup_cache"] = cg.new_Pvariable(
+                ID("wmbus_radio_dedup_cache", is_declaration=True, type=DedupCache),
+                dedup[CONF_CACHE_SIZE],
+                dedup[CONF_WINDOW].total_milliseconds,
+            )
+        cg.add(var.set_dedup_cache(data["dedup_cache"]))
+
     await cg.register_component(var, config)
 
     for conf in config.get(CONF_ON_FRAME, []):
         trig = cg.new_Pvariable(
             conf[CONF_TRIGGER_ID], var, conf[CONF_MARK_AS_HANDLED]
         )
+        if CONF_LINK_MODE in conf:
+            cg.add(trig.set_link_mode(conf[CONF_LINK_MODE]))
+        if CONF_MIN_RSSI in conf:
+            cg.add(trig.set_min_rssi(conf[CONF_MIN_RSSI]))
+        if CONF_MANUFACTURER in conf:
+            cg.add(trig.set_manufacturer(conf[CONF_MANUFACTURER]))
+        if CONF_METER_ID in conf:
+            cg.add(trig.set_meter_id(*conf[CONF_METER_ID]))
+        for ci in conf.get(CONF_CI, []):
+            cg.add(trig.add_ci(ci))
         await automation.build_automation(
             trig,
             [(FramePtr, "frame")],
@@ -189,6 +606,8 @@ with suppress(ImportError):
                 "hex",
                 "raw",
                 "rtlwmbus",
+                "binary",
+                "cbor",
                 lower=True,
             ),
             cv.Optional(CONF_DATA): cv.invalid(
@@ -207,6 +626,8 @@ with suppress(ImportError):
             "hex": cg.std_string,
             "raw": cg.std_vector.template(cg.uint8),
             "rtlwmbus": cg.std_string,
+            "binary": cg.std_vector.template(cg.uint8),
+            "cbor": cg.std_vector.template(cg.uint8),
         }[config[CONF_FORMAT]]
 
         paren = await cg.get_variable(config[CONF_ID])
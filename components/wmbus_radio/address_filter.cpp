@@ -0,0 +1,135 @@
+#include "address_filter.h"
+
+#include <cctype>
+
+namespace esphome {
+namespace wmbus_radio {
+
+size_t AddressFilter::hash_(uint64_t key) {
+  // Fibonacci hashing: spreads the BCD digits over the high bits
+  return (size_t) ((key * 0x9E3779B97F4A7C15ull) >> 32);
+}
+
+bool AddressFilter::contains_(uint64_t key) const {
+  if (this->slots_.empty())
+    return false;
+  const size_t mask = this->slots_.size() - 1;
+  for (size_t i = hash_(key) & mask;; i = (i + 1) & mask) {
+    const uint64_t slot = this->slots_[i];
+    if (slot == key)
+      return true;
+    if (slot == EMPTY)
+      return false;
+  }
+}
+
+void AddressFilter::rehash_(size_t size) {
+  std::vector<uint64_t> old;
+  old.swap(this->slots_);
+  this->slots_.assign(size, EMPTY);
+  this->used_ = this->count_;
+  const size_t mask = size - 1;
+  for (uint64_t key : old) {
+    if (key == EMPTY || key == DELETED)
+      continue;
+    size_t i = hash_(key) & mask;
+    while (this->slots_[i] != EMPTY)
+      i = (i + 1) & mask;
+    this->slots_[i] = key;
+  }
+}
+
+void AddressFilter::add(uint16_t manufacturer, uint32_t id) {
+  const uint64_t key = meter_key(manufacturer, id);
+  if (this->contains_(key))
+    return;
+  // Keep at least half of the slots empty so probes stay short
+  if (2 * (this->used_ + 1) > this->slots_.size()) {
+    size_t size = 16;
+    while (size < 4 * (this->count_ + 1))
+      size <<= 1;
+    this->rehash_(size);
+  }
+  const size_t mask = this->slots_.size() - 1;
+  size_t i = hash_(key) & mask;
+  while (this->slots_[i] != EMPTY && this->slots_[i] != DELETED)
+    i = (i + 1) & mask;
+  if (this->slots_[i] == EMPTY)
+    this->used_++;
+  this->slots_[i] = key;
+  this->count_++;
+}
+
+bool AddressFilter::remove(uint16_t manufacturer, uint32_t id) {
+  if (this->slots_.empty())
+    return false;
+  const uint64_t key = meter_key(manufacturer, id);
+  const size_t mask = this->slots_.size() - 1;
+  for (size_t i = hash_(key) & mask; this->slots_[i] != EMPTY; i = (i + 1) & mask) {
+    if (this->slots_[i] == key) {
+      this->slots_[i] = DELETED;
+      this->count_--;
+      return true;
+    }
+  }
+  return false;
+}
+
+void AddressFilter::clear() {
+  this->slots_.clear();
+  this->count_ = 0;
+  this->used_ = 0;
+}
+
+bool AddressFilter::parse(const std::string &address, uint16_t &manufacturer, uint32_t &id) {
+  size_t pos = 0;
+  manufacturer = ANY_MANUFACTURER;
+  if (address.size() == 12 && address[3] == ':') {
+    // Three letters A..Z, 5 bits each
+    for (size_t i = 0; i < 3; i++) {
+      const char c = (char) std::toupper((unsigned char) address[i]);
+      if (c < 'A' || c > 'Z')
+        return false;
+      manufacturer = (manufacturer << 5) | (uint16_t) (c - 64);
+    }
+    pos = 4;
+  } else if (address.size() != 8) {
+    return false;
+  }
+
+  // The ID is BCD, little-endian in the frame: "12345678" is 0x12345678
+  id = 0;
+  for (; pos < address.size(); pos++) {
+    const char c = address[pos];
+    if (!std::isxdigit((unsigned char) c))
+      return false;
+    id = (id << 4) | (uint32_t) (c <= '9' ? c - '0' : (std::tolower((unsigned char) c) - 'a' + 10));
+  }
+  return true;
+}
+
+bool AddressFilter::add(const std::string &address) {
+  uint16_t manufacturer;
+  uint32_t id;
+  if (!parse(address, manufacturer, id))
+    return false;
+  this->add(manufacturer, id);
+  return true;
+}
+
+bool AddressFilter::remove(const std::string &address) {
+  uint16_t manufacturer;
+  uint32_t id;
+  return parse(address, manufacturer, id) && this->remove(manufacturer, id);
+}
+
+bool AddressFilter::accepts(const FrameHeader &header) const {
+  if (this->mode_ == MODE_NONE)
+    return true;
+  const bool listed = this->contains_(meter_key(header.manufacturer, header.id)) ||
+                      this->contains_(meter_key(ANY_MANUFACTURER, header.id));
+  return listed == (this->mode_ == MODE_ALLOW);
+}
+
+} // namespace wmbus_radio
+} // namespace esphome
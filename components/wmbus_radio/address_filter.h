@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "frame_header.h"
+
+namespace esphome {
+namespace wmbus_radio {
+
+// Allow or deny list of meters, keyed by manufacturer (M-field) and the ID
+// part of the A-field. Version and device type are not part of the key so a
+// firmware update does not change the meter's identity. An entry without a
+// manufacturer matches the ID from any manufacturer.
+//
+// Keys live in an open-addressed hash set: a lookup is two short probes, so
+// frames from meters nobody cares about are dropped for a few hundred cycles.
+class AddressFilter {
+public:
+  enum Mode : uint8_t {
+    MODE_NONE,   // filter disabled
+    MODE_ALLOW,  // only listed meters pass
+    MODE_DENY,   // listed meters are dropped
+  };
+
+  // Matches any manufacturer
+  static constexpr uint16_t ANY_MANUFACTURER = 0;
+
+  void set_mode(Mode mode) { this->mode_ = mode; }
+  Mode mode() const { return this->mode_; }
+  bool is_enabled() const { return this->mode_ != MODE_NONE; }
+
+  void add(uint16_t manufacturer, uint32_t id);
+  bool remove(uint16_t manufacturer, uint32_t id);
+  void clear();
+  size_t size() const { return this->count_; }
+
+  // "12345678" or "KAM:12345678" (ID as printed on the meter, in hex digits)
+  bool add(const std::string &address);
+  bool remove(const std::string &address);
+  static bool parse(const std::string &address, uint16_t &manufacturer, uint32_t &id);
+
+  bool accepts(const FrameHeader &header) const;
+
+protected:
+  static constexpr uint64_t EMPTY = ~uint64_t(0);
+  static constexpr uint64_t DELETED = ~uint64_t(0) - 1;
+
+  static size_t hash_(uint64_t key);
+  bool contains_(uint64_t key) const;
+  void rehash_(size_t size);
+
+  Mode mode_{MODE_NONE};
+  std::vector<uint64_t> slots_;
+  size_t count_{0};
+  // Live plus deleted slots; the table is rebuilt before it gets too full
+  size_t used_{0};
+};
+
+} // namespace wmbus_radio
+} // namespace esphome
@@ -2,6 +2,7 @@
 
 #include "component.h"
 #include "esphome/core/automation.h"
+#include "frame_filter.h"
 #include "packet.h"
 
 namespace esphome {
@@ -9,13 +10,28 @@ namespace wmbus_radio {
 class FrameTrigger : public Trigger<Frame *> {
 public:
   explicit FrameTrigger(wmbus_radio::Radio *radio, bool mark_handled) {
-    radio->add_frame_handler([this, mark_handled](Frame *frame) {
-      this->trigger(frame);
-      if (mark_handled)
-        frame->mark_as_handled();
-    });
+    radio->add_frame_handler(
+        [this, mark_handled](Frame *frame) {
+          this->trigger(frame);
+          if (mark_handled)
+            frame->mark_as_handled();
+        },
+        &this->filter_);
   }
+
+  // Pre-filters: frames that don't match skip this automation entirely
+  void set_link_mode(LinkMode mode) { this->filter_.link_mode = mode; }
+  void set_min_rssi(int8_t rssi) { this->filter_.min_rssi = rssi; }
+  void set_manufacturer(uint16_t manufacturer) { this->filter_.manufacturer = manufacturer; }
+  void set_meter_id(uint32_t value, uint32_t mask) {
+    this->filter_.id_value = value & mask;
+    this->filter_.id_mask = mask;
+  }
+  void add_ci(uint8_t ci) { this->filter_.ci.push_back(ci); }
+
+protected:
+  FrameFilter filter_;
 };
 
 } // namespace wmbus_radio
-} // namespace esphome
\ No newline at end of file
+} // namespace esphome
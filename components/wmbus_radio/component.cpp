@@ -1,14 +1,22 @@
 #include "component.h"
 
-#include "freertos/queue.h"
 #include "freertos/task.h"
 
+#include "esp_timer.h"
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+
 #include "esphome/core/log.h"
 #include "esphome/core/helpers.h"
 
 // Optional: publish diagnostics via ESPHome MQTT if mqtt component is present.
 #include "esphome/components/mqtt/mqtt_client.h"
 
+#include "frame_header.h"
+
 #define WMBUS_PREAMBLE_SIZE (3)
 
 #define ASSERT(expr, expected, before_exit)                                    \
@@ -28,15 +36,48 @@ namespace wmbus_radio {
 static const char *TAG = "wmbus";
 
 
-Radio::DropBucket Radio::bucket_for_reason_(const std::string &reason) {
-  // Keep this stable: these strings come from Packet::set_drop_reason()
-  if (reason == "too_short") return DB_TOO_SHORT;
-  if (reason == "decode_failed") return DB_DECODE_FAILED;
-  if (reason == "dll_crc_strip_failed") return DB_DLL_CRC_STRIP_FAILED;
-  if (reason == "unknown_preamble") return DB_UNKNOWN_PREAMBLE;
-  if (reason == "l_field_invalid") return DB_L_FIELD_INVALID;
-  if (reason == "unknown_link_mode") return DB_UNKNOWN_LINK_MODE;
-  return DB_OTHER;
+// printf-style append that reuses the capacity of `out`, at any length
+static void append_printf(std::string &out, const char *fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  const int n = vsnprintf(nullptr, 0, fmt, args);
+  va_end(args);
+  if (n <= 0)
+    return;
+  const size_t old_size = out.size();
+  // vsnprintf writes a terminator, which lands on the string's own
+  out.resize(old_size + n);
+  va_start(args, fmt);
+  vsnprintf(&out[old_size], n + 1, fmt, args);
+  va_end(args);
+}
+
+static const char *overflow_policy_name(PacketPool::OverflowPolicy policy) {
+  switch (policy) {
+    case PacketPool::OVERFLOW_DROP_OLDEST:
+      return "drop_oldest";
+    case PacketPool::OVERFLOW_DROP_LOWEST_RSSI:
+      return "drop_lowest_rssi";
+    default:
+      return "drop_newest";
+  }
+}
+
+static void append_hex(std::string &out, const uint8_t *data, size_t len) {
+  static const char *hex = "0123456789abcdef";
+  for (size_t i = 0; i < len; i++) {
+    out.push_back(hex[data[i] >> 4]);
+    out.push_back(hex[data[i] & 0x0F]);
+  }
+}
+
+void Radio::count_drop_(DropReason reason, uint32_t count) {
+  if (reason == DropReason::TRUNCATED) {
+    this->diag_truncated_ += count;
+    return;
+  }
+  this->diag_dropped_ += count;
+  this->diag_dropped_by_reason_[(size_t) reason] += count;
 }
 
 void Radio::maybe_publish_diag_summary_(uint32_t now_ms) {
@@ -53,47 +94,340 @@ void Radio::maybe_publish_diag_summary_(uint32_t now_ms) {
   auto *mqtt = esphome::mqtt::global_mqtt_client;
   if (mqtt == nullptr || !mqtt->is_connected()) return;
 
-  char payload[512];
-  snprintf(payload, sizeof(payload),
-           "{"
-           "\"event\":\"summary\","
-           "\"truncated\":%u,"
-           "\"dropped\":%u,"
-           "\"dropped_by_reason\":{"
-           "\"too_short\":%u,"
-           "\"decode_failed\":%u,"
-           "\"dll_crc_strip_failed\":%u,"
-           "\"unknown_preamble\":%u,"
-           "\"l_field_invalid\":%u,"
-           "\"unknown_link_mode\":%u,"
-           "\"other\":%u"
-           "}"
-           "}",
-           (unsigned) this->diag_truncated_,
-           (unsigned) this->diag_dropped_,
-           (unsigned) this->diag_dropped_by_bucket_[DB_TOO_SHORT],
-           (unsigned) this->diag_dropped_by_bucket_[DB_DECODE_FAILED],
-           (unsigned) this->diag_dropped_by_bucket_[DB_DLL_CRC_STRIP_FAILED],
-           (unsigned) this->diag_dropped_by_bucket_[DB_UNKNOWN_PREAMBLE],
-           (unsigned) this->diag_dropped_by_bucket_[DB_L_FIELD_INVALID],
-           (unsigned) this->diag_dropped_by_bucket_[DB_UNKNOWN_LINK_MODE],
-           (unsigned) this->diag_dropped_by_bucket_[DB_OTHER]);
-
-  mqtt->publish(this->diag_topic_, payload);
+  auto &payload = this->diag_payload_;
+  payload.clear();
+  append_printf(payload, "{\"event\":\"summary\",\"truncated\":%u,\"dropped\":%u,\"dropped_by_reason\":{",
+                (unsigned) this->diag_truncated_, (unsigned) this->diag_dropped_);
+  const char *sep = "";
+  for (size_t i = 0; i < (size_t) DropReason::COUNT; i++) {
+    const auto reason = (DropReason) i;
+    if (reason == DropReason::NONE || reason == DropReason::TRUNCATED)
+      continue;
+    append_printf(payload, "%s\"%s\":%u", sep, drop_reason_name(reason),
+                  (unsigned) this->diag_dropped_by_reason_[i]);
+    sep = ",";
+  }
+  payload += '}';
+  if (this->publisher_.is_enabled())
+    append_printf(payload, ",\"published\":%u,\"publish_failed\":%u", (unsigned) this->publisher_.published(),
+                  (unsigned) this->publisher_.failed());
+  if (this->address_filter_.is_enabled())
+    append_printf(payload, ",\"filtered\":%u", (unsigned) this->diag_filtered_);
+  if (this->publisher_.is_enabled() && this->publisher_.delta().keyframes() > 0)
+    append_printf(payload, ",\"delta\":{\"keyframes\":%u,\"deltas\":%u}",
+                  (unsigned) this->publisher_.delta().keyframes(), (unsigned) this->publisher_.delta().deltas());
+  if (this->meter_stats_.is_enabled()) {
+    const uint32_t received = this->meter_stats_.window_received();
+    const uint32_t expected = this->meter_stats_.window_expected();
+    append_printf(payload, ",\"reception\":{\"received\":%u,\"expected\":%u,\"ratio\":%.3f}",
+                  (unsigned) received, (unsigned) expected, expected ? (float) received / expected : 0.0f);
+  }
+  if (this->dedup_cache_ != nullptr) {
+    const uint32_t seen = this->dedup_unique_ + this->dedup_duplicates_;
+    append_printf(payload, ",\"dedup\":{\"unique\":%u,\"duplicate\":%u,\"duplicate_ratio\":%.2f}",
+                  (unsigned) this->dedup_unique_, (unsigned) this->dedup_duplicates_,
+                  seen ? (float) this->dedup_duplicates_ / seen : 0.0f);
+  }
+  if (this->priority_lane_enabled_) {
+    const uint32_t frames = this->priority_frames_;
+    append_printf(payload,
+                  ",\"priority\":{\"frames\":%u,\"alarm\":%u,\"installation\":%u,\"status\":%u,\"failed\":%u,"
+                  "\"latency_avg_ms\":%.1f,\"latency_max_ms\":%.1f}",
+                  (unsigned) frames, (unsigned) this->priority_alarm_, (unsigned) this->priority_installation_,
+                  (unsigned) this->priority_status_, (unsigned) this->priority_failed_,
+                  frames ? this->priority_latency_total_us_ / 1000.0f / frames : 0.0f,
+                  this->priority_latency_max_us_ / 1000.0f);
+    this->priority_frames_ = 0;
+    this->priority_alarm_ = 0;
+    this->priority_installation_ = 0;
+    this->priority_status_ = 0;
+    this->priority_failed_ = 0;
+    this->priority_latency_total_us_ = 0;
+    this->priority_latency_max_us_ = 0;
+  }
+  if (this->publish_policies_.is_enabled()) {
+    uint32_t suppressed = 0;
+    for (const auto &policy : this->publish_policies_.policies())
+      suppressed += policy.suppressed;
+    append_printf(payload, ",\"policy\":{\"suppressed\":%u,\"by_meter\":{", (unsigned) suppressed);
+    const char *meter_sep = "";
+    for (const auto &policy : this->publish_policies_.policies()) {
+      if (policy.suppressed == 0)
+        continue;
+      char address[13];
+      format_meter_address(policy.manufacturer, policy.id, address);
+      append_printf(payload, "%s\"%s\":%u", meter_sep, address, (unsigned) policy.suppressed);
+      meter_sep = ",";
+    }
+    payload += "}}";
+  }
+  if (this->publisher_.is_batching()) {
+    const auto &batch = this->publisher_.batch_stats();
+    const float batches = batch.batches ? (float) batch.batches : 1.0f;
+    append_printf(payload,
+                  ",\"batch\":{\"count\":%u,\"frames_avg\":%.1f,\"frames_max\":%u,\"bytes_avg\":%.0f,"
+                  "\"flushed_full\":%u,\"flushed_timeout\":%u}",
+                  (unsigned) batch.batches, batch.frames / batches, (unsigned) batch.max_frames,
+                  batch.bytes / batches, (unsigned) batch.flushed_full, (unsigned) batch.flushed_timeout);
+  }
+  append_printf(payload,
+                ",\"queue\":{\"depth\":%u,\"policy\":\"%s\",\"high_water\":%u,\"evicted\":%u,"
+                "\"wait_avg_ms\":%.1f,\"wait_max_ms\":%.1f}",
+                (unsigned) this->packet_pool_.depth(), overflow_policy_name(this->packet_pool_.policy()),
+                (unsigned) this->queue_high_water_.exchange(0, std::memory_order_relaxed),
+                (unsigned) this->queue_evictions_.exchange(0, std::memory_order_relaxed),
+                this->queue_wait_count_ ? this->queue_wait_total_us_ / 1000.0f / this->queue_wait_count_ : 0.0f,
+                this->queue_wait_max_us_ / 1000.0f);
+  this->queue_wait_count_ = 0;
+  this->queue_wait_total_us_ = 0;
+  this->queue_wait_max_us_ = 0;
+  // on_frame automations in configuration order
+  if (!this->handlers_.empty()) {
+    payload += ",\"handlers\":[";
+    for (auto &handler : this->handlers_) {
+      append_printf(payload, "%s{\"calls\":%u,\"skipped\":%u,\"us\":%llu,\"max_us\":%u}",
+                    &handler == &this->handlers_.front() ? "" : ",", (unsigned) handler.calls,
+                    (unsigned) handler.skipped, (unsigned long long) handler.total_us, (unsigned) handler.max_us);
+      handler.calls = 0;
+      handler.skipped = 0;
+      handler.total_us = 0;
+      handler.max_us = 0;
+    }
+    payload += ']';
+  }
+  if (this->publish_queue_enabled_) {
+    payload += ",\"publish_queue\":{";
+    for (uint8_t i = 0; i < PublishQueue::PRIORITY_COUNT; i++) {
+      const auto priority = (PublishQueue::Priority) i;
+      const auto &stats = this->publish_queue_.stats(priority);
+      append_printf(payload,
+                    "\"%s\":{\"published\":%u,\"dropped\":%u,\"refused\":%u,\"max_depth\":%u,\"queued\":%u},",
+                    priority == PublishQueue::PRIORITY_TELEGRAM ? "telegram" : "diagnostic",
+                    (unsigned) stats.published, (unsigned) stats.dropped, (unsigned) stats.refused,
+                    (unsigned) stats.max_depth, (unsigned) this->publish_queue_.depth(priority));
+    }
+    append_printf(payload, "\"latency_ms\":{\"p50\":%u,\"p90\":%u,\"p99\":%u,\"max\":%u}}",
+                  (unsigned) this->publish_queue_.latency_percentile_ms(0.5f),
+                  (unsigned) this->publish_queue_.latency_percentile_ms(0.9f),
+                  (unsigned) this->publish_queue_.latency_percentile_ms(0.99f),
+                  (unsigned) this->publish_queue_.latency_max_ms());
+    this->publish_queue_.reset_stats();
+  }
+  if (this->store_forward_.is_enabled()) {
+    const auto &store = this->store_forward_;
+    append_printf(payload,
+                  ",\"store_forward\":{\"backlog\":%u,\"backlog_age_s\":%u,\"ram_bytes\":%u,\"flash_bytes\":%u,"
+                  "\"stored\":%u,\"replayed\":%u,\"dropped\":%u}",
+                  (unsigned) store.backlog(), (unsigned) (store.backlog_age_ms(now_ms) / 1000),
+                  (unsigned) store.ram_bytes(), (unsigned) store.file_bytes(),
+                  (unsigned) store.stored(), (unsigned) store.replayed(), (unsigned) store.dropped());
+    this->store_forward_.reset_stats();
+  }
+  const uint32_t processing_us = this->processing_us_.exchange(0, std::memory_order_relaxed);
+  if (this->processing_task_handle_ != nullptr) {
+    const uint32_t frames = this->processing_frames_.exchange(0, std::memory_order_relaxed);
+    append_printf(payload,
+                  ",\"processing\":{\"packets\":%u,\"avg_us\":%u,\"max_us\":%u,\"queued\":%u,\"decoded\":%u}",
+                  (unsigned) frames, (unsigned) (frames ? processing_us / frames : 0),
+                  (unsigned) this->processing_max_us_.exchange(0, std::memory_order_relaxed),
+                  (unsigned) this->packet_pool_.queued(), (unsigned) this->packet_pool_.processed_queued());
+  }
+  // Stack left at the deepest point so far, and share of the window spent working
+  const float window_us = elapsed * 1000.0f;
+  const uint32_t receiver_us = this->receiver_busy_us_.exchange(0, std::memory_order_relaxed);
+  append_printf(payload, ",\"tasks\":{\"receiver\":{\"stack_free\":%u,\"busy_us\":%u,\"busy_pct\":%.2f}",
+                (unsigned) uxTaskGetStackHighWaterMark(this->receiver_task_handle_), (unsigned) receiver_us,
+                100.0f * receiver_us / window_us);
+  if (this->processing_task_handle_ != nullptr)
+    append_printf(payload, ",\"processing\":{\"stack_free\":%u,\"busy_us\":%u,\"busy_pct\":%.2f}",
+                  (unsigned) uxTaskGetStackHighWaterMark(this->processing_task_handle_), (unsigned) processing_us,
+                  100.0f * processing_us / window_us);
+  payload += '}';
+  payload += '}';
+
+  this->publish_diagnostic_(this->diag_topic_, payload);
   ESP_LOGI(TAG, "DIAG summary published to %s (truncated=%u dropped=%u)",
            this->diag_topic_.c_str(), (unsigned) this->diag_truncated_, (unsigned) this->diag_dropped_);
 
   // Report per-window stats (so it is easy to spot spikes)
   this->diag_truncated_ = 0;
   this->diag_dropped_ = 0;
-  this->diag_dropped_by_bucket_.fill(0);
+  this->diag_dropped_by_reason_.fill(0);
+  this->publisher_.reset_stats();
+  this->diag_filtered_ = 0;
+  this->publish_policies_.reset_stats();
+  this->meter_stats_.reset_window();
+  this->dedup_unique_ = 0;
+  this->dedup_duplicates_ = 0;
+}
+
+void Radio::handle_rejected_packet_(Packet *p) {
+  // ---- Diagnostics accounting (always count, even if verbose is disabled)
+  const DropReason reason = p->drop_reason();
+  this->count_drop_(reason);
+  if (!this->diag_verbose_)
+    return;
+
+  // Build payload (optionally with raw)
+  const bool truncated = reason == DropReason::TRUNCATED;
+  const char *mode = link_mode_name(p->get_link_mode());
+  auto &payload = this->diag_payload_;
+  payload.clear();
+  if (truncated)
+    payload += "{\"event\":\"truncated\"";
+  else
+    append_printf(payload, "{\"event\":\"dropped\",\"reason\":\"%s\"", drop_reason_name(reason));
+  append_printf(payload, ",\"mode\":\"%s\",\"rssi\":%d,\"want\":%u,\"got\":%u,\"raw_got\":%u", mode,
+                (int) p->get_rssi(), (unsigned) p->want_len(), (unsigned) p->got_len(),
+                (unsigned) p->raw_got_len());
+
+  // T1 frames rejected after in-place decoding no longer hold the raw bytes:
+  // publish what is there under a different key.
+  const char *bytes_kind = p->is_raw() ? "raw" : "decoded";
+  size_t hex_pos = 0;
+  size_t hex_len = 0;
+  if (this->diag_publish_raw_) {
+    append_printf(payload, ",\"%s\":\"", bytes_kind);
+    hex_pos = payload.size();
+    // Keep it bounded: 256 bytes -> 512 hex chars, enough for typical dropped packets.
+    append_hex(payload, p->data(), std::min<size_t>(p->size(), 256));
+    hex_len = payload.size() - hex_pos;
+    payload += '"';
+  }
+  payload += '}';
+
+  if (truncated) {
+    ESP_LOGW(TAG, "TRUNCATED frame: mode=%s want=%u got=%u raw_got=%u RSSI=%ddBm", mode,
+             (unsigned) p->want_len(), (unsigned) p->got_len(), (unsigned) p->raw_got_len(),
+             (int) p->get_rssi());
+  } else {
+    ESP_LOGW(TAG, "DROPPED packet: reason=%s mode=%s want=%u got=%u raw_got=%u RSSI=%ddBm",
+             drop_reason_name(reason), mode, (unsigned) p->want_len(), (unsigned) p->got_len(),
+             (unsigned) p->raw_got_len(), (int) p->get_rssi());
+  }
+
+  if (this->diag_publish_raw_) {
+    ESP_LOGW(TAG, "%s %s(hex)=%.*s", truncated ? "TRUNCATED" : "DROPPED", bytes_kind, (int) hex_len,
+             payload.c_str() + hex_pos);
+  }
+
+  if (!this->diag_topic_.empty())
+    this->publish_diagnostic_(this->diag_topic_, payload);
+}
+
+void Radio::publish_diagnostic_(const std::string &topic, const std::string &payload) {
+  if (this->publish_queue_enabled_) {
+    this->publish_queue_.enqueue(PublishQueue::PRIORITY_DIAGNOSTIC, topic, payload);
+    return;
+  }
+  if (mqtt::global_mqtt_client != nullptr)
+    mqtt::global_mqtt_client->publish(topic, payload);
+}
+
+bool Radio::publish(const std::string &topic, const std::string &payload) {
+  if (this->store_forward_.should_store())
+    return this->store_forward_.store(topic, payload.data(), payload.size());
+  if (this->publish_queue_enabled_)
+    return this->publish_queue_.enqueue(PublishQueue::PRIORITY_TELEGRAM, topic, payload);
+  if (mqtt::global_mqtt_client != nullptr && mqtt::global_mqtt_client->publish(topic, payload))
+    return true;
+  return this->store_forward_.store(topic, payload.data(), payload.size());
+}
+
+void Radio::request_meter_stats_(const std::string &payload) {
+  const size_t pages = (this->meter_stats_.size() + this->meter_stats_page_size_ - 1) / this->meter_stats_page_size_;
+  // Empty or "all": every page, otherwise the page number
+  if (payload.empty() || payload == "all") {
+    this->meter_stats_next_page_ = 0;
+    this->meter_stats_end_page_ = std::max<size_t>(pages, 1);
+    return;
+  }
+  char *end;
+  const unsigned long page = strtoul(payload.c_str(), &end, 10);
+  if (*end != '\0') {
+    ESP_LOGW(TAG, "Invalid meter statistics request: %s", payload.c_str());
+    return;
+  }
+  this->meter_stats_next_page_ = page;
+  this->meter_stats_end_page_ = page + 1;
+}
+
+void Radio::publish_meter_stats_page_(uint32_t now_ms) {
+  auto *mqtt = esphome::mqtt::global_mqtt_client;
+  if (mqtt == nullptr || !mqtt->is_connected())
+    return;
+
+  const size_t page = this->meter_stats_next_page_++;
+  const size_t page_size = this->meter_stats_page_size_;
+  const size_t count = this->meter_stats_.size();
+  const size_t pages = (count + page_size - 1) / page_size;
+  auto &payload = this->diag_payload_;
+  payload.clear();
+  append_printf(payload, "{\"page\":%u,\"pages\":%u,\"meters\":%u,\"evictions\":%u,\"entries\":[",
+                (unsigned) page, (unsigned) pages, (unsigned) count, (unsigned) this->meter_stats_.evictions());
+  const size_t end = std::min(count, (page + 1) * page_size);
+  for (size_t i = page * page_size; i < end; i++) {
+    const auto &entry = this->meter_stats_.entry(i);
+    char address[13];
+    format_meter_address(entry.manufacturer, entry.id, address);
+    append_printf(payload,
+                  "%s{\"address\":\"%s\",\"mode\":\"%s\",\"frames\":%u,\"rssi\":%d,\"rssi_min\":%d,"
+                  "\"rssi_max\":%d,\"rssi_avg\":%.1f,\"last_seen_s\":%u,\"interval_s\":%.1f",
+                  i > page * page_size ? "," : "", address, link_mode_name(entry.link_mode), (unsigned) entry.frames,
+                  (int) entry.rssi_last, (int) entry.rssi_min, (int) entry.rssi_max, entry.rssi_avg,
+                  (unsigned) ((now_ms - entry.last_seen_ms) / 1000), entry.mean_interval_ms / 1000.0f);
+    // Loss measured from access number gaps (meters without ACC: none)
+    if (entry.has_access_number)
+      append_printf(payload, ",\"acc_received\":%u,\"acc_expected\":%u,\"reception\":%.3f",
+                    (unsigned) entry.acc_received, (unsigned) entry.acc_expected,
+                    (float) entry.acc_received / entry.acc_expected);
+    payload += '}';
+  }
+  payload += "]}";
+  this->publish_diagnostic_(this->meter_stats_topic_, payload);
+}
+
+bool Radio::create_task_(TaskFunction_t function, const char *name, const TaskOptions &options, void *arg,
+                         TaskHandle_t *handle) {
+  const BaseType_t core = options.core < 0 ? tskNO_AFFINITY : options.core;
+  ESP_LOGD(TAG, "Creating task %s: core %d, priority %u, stack %u bytes", name, (int) options.core,
+           (unsigned) options.priority, (unsigned) options.stack_size);
+  return xTaskCreatePinnedToCore(function, name, options.stack_size, arg, options.priority, handle, core) == pdPASS;
 }
 
 void Radio::setup() {
-  ASSERT_SETUP(this->packet_queue_ = xQueueCreate(3, sizeof(Packet *)));
+  if (this->dedup_cache_ != nullptr)
+    this->dedup_cache_->init();
+
+  ASSERT_SETUP(this->packet_pool_.init(this->queue_depth_, this->queue_in_psram_, this->queue_overflow_));
+
+  if (this->publish_queue_enabled_) {
+    this->publish_queue_.setup();
+    this->publisher_.set_queue(&this->publish_queue_);
+  }
+  if (!this->store_forward_partition_.empty() &&
+      !StoreForward::mount_littlefs(this->store_forward_partition_.c_str(), STORE_FORWARD_BASE_PATH))
+    this->store_forward_.set_spill("", 0);
+  if (this->store_forward_.setup())
+    this->publisher_.set_store(&this->store_forward_);
+  this->publisher_.setup();
+
+  if (this->meter_stats_capacity_ > 0 && this->meter_stats_.init(this->meter_stats_capacity_) &&
+      mqtt::global_mqtt_client != nullptr) {
+    mqtt::global_mqtt_client->subscribe(this->meter_stats_topic_ + "/get",
+                                        [this](const std::string &topic, const std::string &payload) {
+                                          this->request_meter_stats_(payload);
+                                        });
+  }
+
+  if (this->processing_task_enabled_) {
+    ASSERT_SETUP(create_task_((TaskFunction_t) this->processing_task, "radio_proc", this->processing_task_options_,
+                              this, &(this->processing_task_handle_)));
+    ESP_LOGI(TAG, "Processing task created [%p]", this->processing_task_handle_);
+  }
 
-  ASSERT_SETUP(xTaskCreate((TaskFunction_t)this->receiver_task, "radio_recv",
-                           3 * 1024, this, 2, &(this->receiver_task_handle_)));
+  ASSERT_SETUP(create_task_((TaskFunction_t) this->receiver_task, "radio_recv", this->receiver_task_options_, this,
+                            &(this->receiver_task_handle_)));
 
   ESP_LOGI(TAG, "Receiver task created [%p]", this->receiver_task_handle_);
 
@@ -102,102 +436,162 @@ void Radio::setup() {
 }
 
 void Radio::loop() {
-  this->maybe_publish_diag_summary_((uint32_t) esphome::millis());
-  Packet *p;
-  if (xQueueReceive(this->packet_queue_, &p, 0) != pdPASS)
-    return;
+  // Packets the receiver task could not hand over since the last loop()
+  const uint32_t queue_full = this->queue_full_drops_.exchange(0, std::memory_order_relaxed);
+  if (queue_full)
+    this->count_drop_(DropReason::QUEUE_FULL, queue_full);
+
+  const uint32_t now = (uint32_t) esphome::millis();
+  this->maybe_publish_diag_summary_(now);
+  if (this->publisher_.is_enabled())
+    this->publisher_.loop(now);
+  if (this->meter_stats_next_page_ < this->meter_stats_end_page_)
+    this->publish_meter_stats_page_(now);
+
+  if (this->processing_task_handle_ == nullptr) {
+    Packet *p = this->packet_pool_.receive();
+    if (p != nullptr)
+      this->handle_packet_(p, now);
+  } else {
+    // Already decoded: handle everything that is waiting (at most the pool)
+    for (Packet *p = this->packet_pool_.receive_processed(); p != nullptr;
+         p = this->packet_pool_.receive_processed())
+      this->handle_packet_(p, now);
+  }
+
+  // Publish last: the packets are back in the pool by now
+  if (this->publish_queue_enabled_)
+    this->publish_queue_.loop();
+  if (this->store_forward_.is_enabled())
+    this->store_forward_.loop(now);
+}
+
+void Radio::handle_packet_(Packet *p, uint32_t now) {
+  const uint32_t waited_us = (uint32_t) (esp_timer_get_time() - p->queued_at_us());
+  this->queue_wait_count_++;
+  this->queue_wait_total_us_ += waited_us;
+  this->queue_wait_max_us_ = std::max(this->queue_wait_max_us_, waited_us);
 
   auto frame = p->convert_to_frame();
   if (!frame) {
-    // ---- Diagnostics accounting (always count, even if verbose is disabled)
-    const char *mode = link_mode_name(p->get_link_mode());
-    if (p->is_truncated()) {
-      this->diag_truncated_++;
-
-      if (this->diag_verbose_) {
-        // Build payload (optionally with raw)
-        char payload[900];
-        if (this->diag_publish_raw_) {
-          snprintf(payload, sizeof(payload),
-                   "{\"event\":\"truncated\",\"mode\":\"%s\",\"rssi\":%d,\"want\":%u,\"got\":%u,\"raw_got\":%u,\"raw\":\"%s\"}",
-                   mode, (int) p->get_rssi(), (unsigned) p->want_len(),
-                   (unsigned) p->got_len(), (unsigned) p->raw_got_len(),
-                   p->raw_hex().c_str());
-        } else {
-          snprintf(payload, sizeof(payload),
-                   "{\"event\":\"truncated\",\"mode\":\"%s\",\"rssi\":%d,\"want\":%u,\"got\":%u,\"raw_got\":%u}",
-                   mode, (int) p->get_rssi(), (unsigned) p->want_len(),
-                   (unsigned) p->got_len(), (unsigned) p->raw_got_len());
-        }
-
-        ESP_LOGW(TAG,
-                 "TRUNCATED frame: mode=%s want=%u got=%u raw_got=%u RSSI=%ddBm",
-                 mode, (unsigned) p->want_len(), (unsigned) p->got_len(),
-                 (unsigned) p->raw_got_len(), (int) p->get_rssi());
-
-        if (this->diag_publish_raw_) {
-          ESP_LOGW(TAG, "TRUNCATED raw(hex)=%s", p->raw_hex().c_str());
-        }
-
-        if (mqtt::global_mqtt_client != nullptr && !this->diag_topic_.empty()) {
-          mqtt::global_mqtt_client->publish(this->diag_topic_, payload);
-        }
-      }
-    } else if (!p->drop_reason().empty()) {
-      this->diag_dropped_++;
-      auto bucket = bucket_for_reason_(p->drop_reason());
-      this->diag_dropped_by_bucket_[bucket]++;
-
-      if (this->diag_verbose_) {
-        char payload[900];
-        if (this->diag_publish_raw_) {
-          snprintf(payload, sizeof(payload),
-                   "{\"event\":\"dropped\",\"reason\":\"%s\",\"mode\":\"%s\",\"rssi\":%d,\"want\":%u,\"got\":%u,\"raw_got\":%u,\"raw\":\"%s\"}",
-                   p->drop_reason().c_str(), mode, (int) p->get_rssi(),
-                   (unsigned) p->want_len(), (unsigned) p->got_len(),
-                   (unsigned) p->raw_got_len(), p->raw_hex().c_str());
-        } else {
-          snprintf(payload, sizeof(payload),
-                   "{\"event\":\"dropped\",\"reason\":\"%s\",\"mode\":\"%s\",\"rssi\":%d,\"want\":%u,\"got\":%u,\"raw_got\":%u}",
-                   p->drop_reason().c_str(), mode, (int) p->get_rssi(),
-                   (unsigned) p->want_len(), (unsigned) p->got_len(),
-                   (unsigned) p->raw_got_len());
-        }
-
-        ESP_LOGW(TAG,
-                 "DROPPED packet: reason=%s mode=%s want=%u got=%u raw_got=%u RSSI=%ddBm",
-                 p->drop_reason().c_str(), mode, (unsigned) p->want_len(),
-                 (unsigned) p->got_len(), (unsigned) p->raw_got_len(),
-                 (int) p->get_rssi());
-
-        if (this->diag_publish_raw_) {
-          ESP_LOGW(TAG, "DROPPED raw(hex)=%s", p->raw_hex().c_str());
-        }
-
-        if (mqtt::global_mqtt_client != nullptr && !this->diag_topic_.empty()) {
-          mqtt::global_mqtt_client->publish(this->diag_topic_, payload);
-        }
-      }
+    this->handle_rejected_packet_(p);
+    this->packet_pool_.release(p);
+    return;
+  }
+
+  // Meters we don't care about: drop before any other work
+  if (!this->address_filter_.accepts(frame->header())) {
+    this->diag_filtered_++;
+    this->packet_pool_.release(p);
+    return;
+  }
+
+  const uint8_t priority = this->priority_lane_enabled_
+                               ? priority_reasons(frame->header(), frame->data(), frame->size(),
+                                                  this->priority_status_mask_)
+                               : 0;
+
+  // Repeats (and the same frame from another radio) stop here, before
+  // anything is rendered, logged or published. Urgent frames always pass,
+  // but are looked up too so that the statistics below see them once.
+  const bool duplicate =
+      this->dedup_cache_ != nullptr && this->dedup_cache_->check_and_insert(frame->data(), frame->size(), now);
+  if (this->dedup_cache_ != nullptr && priority == 0) {
+    if (duplicate) {
+      this->dedup_duplicates_++;
+      ESP_LOGV(TAG, "Duplicate telegram suppressed (%zu bytes)", frame->size());
+      this->packet_pool_.release(p);
+      return;
     }
+    this->dedup_unique_++;
+  }
 
-    delete p;
+  // Reception statistics count each telegram once, however many copies
+  // arrived, or the ACC gaps and intervals would be off
+  if (!duplicate)
+    this->meter_stats_.record(frame->header(), frame->data(), frame->size(), frame->rssi(), frame->link_mode(),
+                              now);
+
+  if (priority == 0 && !this->publish_policies_.should_publish(frame->header(), frame->data(), frame->size(), now)) {
+    ESP_LOGV(TAG, "Telegram suppressed by publish policy");
+    this->packet_pool_.release(p);
     return;
   }
 
-  ESP_LOGI(TAG, "Have data (%zu bytes) [RSSI: %ddBm, mode: %s %s]",
-           frame->data().size(), frame->rssi(),
+  frame->set_text_cache(&this->frame_text_);
+  frame->set_sequence(this->frame_sequence_++);
+
+  ESP_LOGI(TAG, "Have data (%zu bytes) [RSSI: %ddBm, mode: %s %.*s]",
+           frame->size(), frame->rssi(),
            link_mode_name(frame->link_mode()),
-           frame->format().c_str());
+           (int) frame->format().size(), frame->format().data());
+
+  if (priority != 0)
+    this->publish_priority_(&frame.value(), p, priority);
 
-  for (auto &handler : this->handlers_)
-    handler(&frame.value());
+  for (auto &handler : this->handlers_) {
+    if (handler.filter != nullptr && !handler.filter->matches(&frame.value())) {
+      handler.skipped++;
+      continue;
+    }
+    const int64_t start = esp_timer_get_time();
+    handler.callback(&frame.value());
+    const uint32_t elapsed_us = (uint32_t) (esp_timer_get_time() - start);
+    handler.calls++;
+    handler.total_us += elapsed_us;
+    handler.max_us = std::max(handler.max_us, elapsed_us);
+  }
 
   if (frame->handlers_count())
     ESP_LOGI(TAG, "Telegram handled by %d handlers", frame->handlers_count());
   else
     ESP_LOGD(TAG, "Telegram not handled by any handler");
 
-  delete p;
+  if (this->publisher_.is_enabled() && priority == 0)
+    this->publisher_.publish(&frame.value());
+
+  this->packet_pool_.release(p);
+}
+
+void Radio::publish_priority_(Frame *frame, const Packet *p, uint8_t reasons) {
+  ESP_LOGW(TAG, "Urgent telegram from %s %08x:%s%s%s", frame->header().manufacturer_code,
+           (unsigned) frame->header().id, reasons & PRIORITY_ALARM ? " alarm" : "",
+           reasons & PRIORITY_INSTALLATION ? " installation" : "", reasons & PRIORITY_STATUS ? " status" : "");
+  this->priority_frames_++;
+  if (reasons & PRIORITY_ALARM)
+    this->priority_alarm_++;
+  if (reasons & PRIORITY_INSTALLATION)
+    this->priority_installation_++;
+  if (reasons & PRIORITY_STATUS)
+    this->priority_status_++;
+
+  if (this->publisher_.is_enabled() && !this->publisher_.publish_now(frame))
+    this->priority_failed_++;
+  const uint32_t latency_us = (uint32_t) (esp_timer_get_time() - p->queued_at_us());
+  this->priority_latency_total_us_ += latency_us;
+  this->priority_latency_max_us_ = std::max(this->priority_latency_max_us_, latency_us);
+}
+
+void Radio::process_packets_() {
+  for (Packet *p = this->packet_pool_.receive_for_processing(); p != nullptr;
+       p = this->packet_pool_.receive_for_processing()) {
+    const int64_t start = esp_timer_get_time();
+    p->convert_to_frame();
+    const uint32_t elapsed_us = (uint32_t) (esp_timer_get_time() - start);
+    this->processing_frames_.fetch_add(1, std::memory_order_relaxed);
+    this->processing_us_.fetch_add(elapsed_us, std::memory_order_relaxed);
+    if (elapsed_us > this->processing_max_us_.load(std::memory_order_relaxed))
+      this->processing_max_us_.store(elapsed_us, std::memory_order_relaxed);
+    this->packet_pool_.forward(p);
+  }
+}
+
+void Radio::processing_task(Radio *arg) {
+  while (true) {
+    // Woken by the receiver task for every submitted packet
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    arg->process_packets_();
+  }
 }
 
 void Radio::wakeup_receiver_task_from_isr(TaskHandle_t *arg) {
@@ -207,25 +601,54 @@ void Radio::wakeup_receiver_task_from_isr(TaskHandle_t *arg) {
 }
 
 void Radio::receive_frame() {
+  if (!this->wait_for_packet_())
+    return;
+  const int64_t start = esp_timer_get_time();
+  this->read_packet_();
+  this->receiver_busy_us_.fetch_add((uint32_t) (esp_timer_get_time() - start), std::memory_order_relaxed);
+}
+
+bool Radio::wait_for_packet_() {
   // Ping-pong helper: restart RX in short windows to alternate sync bytes.
   // This dramatically improves hit rate for devices that transmit rarely.
   const uint32_t total_wait_ms = 60000;
   const uint32_t hop_ms = 500;
   uint32_t waited = 0;
-  bool got_irq = false;
   while (waited < total_wait_ms) {
     this->radio->restart_rx();
-    if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(hop_ms))) {
-      got_irq = true;
-      break;
-    }
+    if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(hop_ms)))
+      return true;
     waited += hop_ms;
   }
-  if (!got_irq) {
-    ESP_LOGD(TAG, "Radio interrupt timeout");
+  ESP_LOGD(TAG, "Radio interrupt timeout");
+  return false;
+}
+
+void Radio::read_packet_() {
+  // The spare is only read into while every other packet is in use: give it
+  // back, a free packet may be available by now
+  if (this->rx_overflow_) {
+    this->packet_pool_.restore_spare(this->rx_packet_);
+    this->rx_packet_ = nullptr;
+    this->rx_overflow_ = false;
+  }
+  // Reuse the packet left over from a failed read, otherwise take a free one
+  // from the pool. All packets in flight means loop() is not keeping up: read
+  // into the spare (if the overflow policy keeps one) and decide afterwards.
+  if (this->rx_packet_ == nullptr)
+    this->rx_packet_ = this->packet_pool_.acquire();
+  if (this->rx_packet_ == nullptr) {
+    this->rx_packet_ = this->packet_pool_.take_spare();
+    this->rx_overflow_ = this->rx_packet_ != nullptr;
+  }
+  if (this->rx_packet_ == nullptr) {
+    this->queue_full_drops_.fetch_add(1, std::memory_order_relaxed);
+    ESP_LOGW(TAG, "Packet queue full (%u packets), dropping frame",
+             (unsigned) this->packet_pool_.depth());
     return;
   }
-  auto packet = std::make_unique<Packet>();
+  auto *packet = this->rx_packet_;
+  packet->reset();
 
   // Read the minimal header needed to determine expected length.
   auto *preamble = packet->append_space(WMBUS_PREAMBLE_SIZE);
@@ -240,25 +663,60 @@ void Radio::receive_frame() {
     return;
   }
 
-  const size_t remaining = total_len - WMBUS_PREAMBLE_SIZE;
-  if (remaining > 0) {
-    auto *rest = packet->append_space(remaining);
-    if (!this->radio->read_in_task(rest, remaining)) {
+  // T1 format B frames are shorter than format A ones and we can't tell
+  // them apart yet: only min_len bytes are required, the rest is optional.
+  const size_t min_len = packet->min_expected_size();
+  if (total_len > PACKET_CAPACITY) {
+    ESP_LOGD(TAG, "Payload size %zu exceeds packet buffer", total_len);
+    return;
+  }
+
+  const size_t required = min_len - WMBUS_PREAMBLE_SIZE;
+  if (required > 0) {
+    auto *rest = packet->append_space(required);
+    if (!this->radio->read_in_task(rest, required)) {
       ESP_LOGW(TAG, "Failed to read data");
       return;
     }
   }
 
+  const size_t optional_len = total_len - min_len;
+  if (optional_len > 0) {
+    auto *tail = packet->append_space(optional_len);
+    if (!this->radio->read_in_task(tail, optional_len)) {
+      ESP_LOGV(TAG, "Frame ended after %zu bytes", min_len);
+      packet->shrink_to(min_len);
+    }
+  }
+
   packet->set_rssi(this->radio->get_rssi());
-  auto packet_ptr = packet.get();
-
-  if (xQueueSend(this->packet_queue_, &packet_ptr, 0) == pdTRUE) {
-    ESP_LOGV(TAG, "Queue items: %zu",
-             uxQueueMessagesWaiting(this->packet_queue_));
-    ESP_LOGV(TAG, "Queue send success");
-    packet.release();
-  } else
+  packet->stamp_rx_time();
+
+  if (this->rx_overflow_) {
+    // Either a queued packet makes room or the new one is dropped
+    this->queue_full_drops_.fetch_add(1, std::memory_order_relaxed);
+    if (!this->packet_pool_.evict_for(packet)) {
+      ESP_LOGW(TAG, "Packet queue full (%u packets), dropping frame (RSSI %ddBm)",
+               (unsigned) this->packet_pool_.depth(), (int) packet->get_rssi());
+      return;
+    }
+    this->queue_evictions_.fetch_add(1, std::memory_order_relaxed);
+    this->rx_overflow_ = false;
+    ESP_LOGW(TAG, "Packet queue full (%u packets), dropped a queued frame", (unsigned) this->packet_pool_.depth());
+  }
+
+  if (this->packet_pool_.submit(packet)) {
+    ESP_LOGV(TAG, "Queue items: %zu", this->packet_pool_.queued());
+    this->rx_packet_ = nullptr;
+    const uint32_t queued = this->packet_pool_.waiting();
+    if (queued > this->queue_high_water_.load(std::memory_order_relaxed))
+      this->queue_high_water_.store(queued, std::memory_order_relaxed);
+    if (this->processing_task_handle_ != nullptr)
+      xTaskNotifyGive(this->processing_task_handle_);
+  } else {
+    this->queue_full_drops_.fetch_add(1, std::memory_order_relaxed);
     ESP_LOGW(TAG, "Queue send failed");
+  }
 }
 
 void Radio::receiver_task(Radio *arg) {
@@ -266,8 +724,8 @@ void Radio::receiver_task(Radio *arg) {
     arg->receive_frame();
 }
 
-void Radio::add_frame_handler(std::function<void(Frame *)> &&callback) {
-  this->handlers_.push_back(std::move(callback));
+void Radio::add_frame_handler(std::function<void(Frame *)> &&callback, const FrameFilter *filter) {
+  this->handlers_.push_back({std::move(callback), filter, 0, 0, 0, 0});
 }
 
 } // namespace wmbus_radio
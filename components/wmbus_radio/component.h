@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <cstdint>
 #include <vector>
 
@@ -16,12 +17,28 @@
 // Keep component lightweight (no full wmbusmeters stack)
 #include "link_mode.h"
 
+#include "address_filter.h"
+#include "dedup_cache.h"
+#include "frame_filter.h"
+#include "meter_stats.h"
 #include "packet.h"
+#include "packet_pool.h"
+#include "publish_policy.h"
+#include "publish_queue.h"
+#include "store_forward.h"
+#include "telegram_publisher.h"
 #include "transceiver.h"
 
 namespace esphome {
 namespace wmbus_radio {
 
+// Where and how a FreeRTOS task of the radio runs
+struct TaskOptions {
+  int8_t core;  // -1: no affinity
+  uint8_t priority;
+  uint32_t stack_size;  // bytes
+};
+
 class Radio : public Component {
 public:
   void set_radio(RadioTransceiver *radio) { this->radio = radio; };
@@ -35,21 +52,186 @@ public:
     this->diag_summary_interval_ms_ = interval_ms < 5000 ? 5000 : interval_ms;
   }
 
+  // Number of preallocated packets shared by the receiver task and loop()
+  void set_queue_depth(uint8_t depth) { this->queue_depth_ = depth; }
+  void set_queue_in_psram(bool enabled) { this->queue_in_psram_ = enabled; }
+  void set_queue_overflow(PacketPool::OverflowPolicy policy) { this->queue_overflow_ = policy; }
+
+  // Placement of the receiver task and of the optional processing task,
+  // which decodes packets instead of loop() (loop() then handles every
+  // decoded packet at once)
+  void set_receiver_task(int8_t core, uint8_t priority, uint32_t stack_size) {
+    this->receiver_task_options_ = {core, priority, stack_size};
+  }
+  void set_processing_task(int8_t core, uint8_t priority, uint32_t stack_size) {
+    this->processing_task_enabled_ = true;
+    this->processing_task_options_ = {core, priority, stack_size};
+  }
+
+  // Built-in publishing of every accepted frame (disabled without a topic)
+  void set_telegram_topic(const std::string &topic) { this->publisher_.set_topic(topic); }
+  void set_telegram_format(Frame::OutputFormat format) { this->publisher_.set_format(format); }
+  void set_telegram_topic_per_meter(bool enabled) { this->publisher_.set_topic_per_meter(enabled); }
+  void set_telegram_delta(uint16_t meters, uint8_t keyframe_interval) {
+    this->publisher_.set_delta(meters, keyframe_interval);
+  }
+  void set_telegram_batch(uint32_t max_delay_ms, size_t max_bytes) {
+    this->publisher_.set_batch(max_delay_ms, max_bytes);
+  }
+
+  // Meter allow/deny list. Can be changed at runtime through
+  // address_filter() (e.g. from a lambda: add("KAM:12345678")).
+  void set_address_filter_mode(AddressFilter::Mode mode) { this->address_filter_.set_mode(mode); }
+  void add_filter_address(uint16_t manufacturer, uint32_t id) { this->address_filter_.add(manufacturer, id); }
+  AddressFilter &address_filter() { return this->address_filter_; }
+
+  // Per-meter rate limit (manufacturer 0 matches any manufacturer)
+  void add_publish_policy(uint16_t manufacturer, uint32_t id, uint32_t min_interval_ms, bool on_change_only,
+                          uint32_t heartbeat_ms) {
+    this->publish_policies_.add(manufacturer, id, min_interval_ms, on_change_only, heartbeat_ms);
+  }
+
+  // Per-meter reception statistics, published page by page on request
+  void set_meter_stats_capacity(uint16_t capacity) { this->meter_stats_capacity_ = capacity; }
+  void set_meter_stats_topic(const std::string &topic) { this->meter_stats_topic_ = topic; }
+  void set_meter_stats_page_size(uint8_t page_size) { this->meter_stats_page_size_ = page_size; }
+
+  // Publish from a bounded queue drained by loop() instead of synchronously
+  void set_publish_queue(size_t telegrams, size_t diagnostics, uint32_t loop_budget_us) {
+    this->publish_queue_enabled_ = true;
+    this->publish_queue_.set_capacity(PublishQueue::PRIORITY_TELEGRAM, telegrams);
+    this->publish_queue_.set_capacity(PublishQueue::PRIORITY_DIAGNOSTIC, diagnostics);
+    this->publish_queue_.set_loop_budget_us(loop_budget_us);
+  }
+  // Keep telegrams while the broker is unreachable and replay them after
+  void set_store_forward(size_t ram_size, bool in_psram, uint16_t replay_rate) {
+    this->store_forward_.set_ram_size(ram_size);
+    this->store_forward_.set_in_psram(in_psram);
+    this->store_forward_.set_replay_rate(replay_rate);
+  }
+  // Spill to a log file on the given LittleFS partition once RAM is full
+  void set_store_forward_flash(const std::string &partition, size_t max_size) {
+    this->store_forward_partition_ = partition;
+    this->store_forward_.set_spill(std::string(STORE_FORWARD_BASE_PATH) + "/spool.bin", max_size);
+  }
+  // For lambdas: publish at telegram priority, through the queue if enabled
+  // (and through the store while the broker is unreachable)
+  bool publish(const std::string &topic, const std::string &payload);
+
+  // Drop frames already seen within the cache window (may be shared by radios)
+  void set_dedup_cache(DedupCache *cache) { this->dedup_cache_ = cache; }
+
+  // Alarms, installation requests and frames with `status_mask` bits set in
+  // the TPL status skip dedup and publish policies and are published before
+  // the on_frame handlers run, past the publish queue and batching
+  void set_priority_lane(uint8_t status_mask) {
+    this->priority_lane_enabled_ = true;
+    this->priority_status_mask_ = status_mask;
+  }
+
   void setup() override;
   void loop() override;
   void receive_frame();
 
-  void add_frame_handler(std::function<void(Frame *)> &&callback);
+  // `filter` (optional) must outlive the radio; frames it rejects skip the handler
+  void add_frame_handler(std::function<void(Frame *)> &&callback, const FrameFilter *filter = nullptr);
 
 protected:
   static void wakeup_receiver_task_from_isr(TaskHandle_t *arg);
   static void receiver_task(Radio *arg);
+  static void processing_task(Radio *arg);
+
+  static bool create_task_(TaskFunction_t function, const char *name, const TaskOptions &options, void *arg,
+                           TaskHandle_t *handle);
+  // Blocks until the radio signals a packet (false on timeout)
+  bool wait_for_packet_();
+  void read_packet_();
 
   RadioTransceiver *radio{nullptr};
+  TaskOptions receiver_task_options_{-1, 2, 3 * 1024};
   TaskHandle_t receiver_task_handle_{nullptr};
-  QueueHandle_t packet_queue_{nullptr};
+  // Time the receiver task spent reading packets (not waiting), reset with the summary
+  std::atomic<uint32_t> receiver_busy_us_{0};
+
+  uint8_t queue_depth_{8};
+  bool queue_in_psram_{false};
+  PacketPool packet_pool_;
+  // Packet the receiver task is currently filling (owned by that task)
+  Packet *rx_packet_{nullptr};
+  PacketPool::OverflowPolicy queue_overflow_{PacketPool::OVERFLOW_DROP_NEWEST};
+  // rx_packet_ is the pool's spare, read into because all packets were in use
+  bool rx_overflow_{false};
+  // Incremented by the receiver task, folded into diagnostics by loop()
+  std::atomic<uint32_t> queue_full_drops_{0};
+  // Written by the receiver task, read and reset with the summary
+  std::atomic<uint32_t> queue_evictions_{0};
+  std::atomic<uint32_t> queue_high_water_{0};
+  // Time from queueing to loop() (decoding included with a processing task)
+  uint32_t queue_wait_count_{0};
+  uint64_t queue_wait_total_us_{0};
+  uint32_t queue_wait_max_us_{0};
+
+  bool processing_task_enabled_{false};
+  TaskOptions processing_task_options_{-1, 2, 3 * 1024};
+  TaskHandle_t processing_task_handle_{nullptr};
+  // Written by the processing task, read and reset with the summary
+  std::atomic<uint32_t> processing_frames_{0};
+  std::atomic<uint32_t> processing_us_{0};
+  std::atomic<uint32_t> processing_max_us_{0};
+  void process_packets_();
+
+  void handle_packet_(Packet *p, uint32_t now);
 
-  std::vector<std::function<void(Frame *)>> handlers_;
+  struct FrameHandler {
+    std::function<void(Frame *)> callback;
+    const FrameFilter *filter;
+    // Per summary window
+    uint32_t calls;
+    uint32_t skipped;
+    uint64_t total_us;
+    uint32_t max_us;
+  };
+  std::vector<FrameHandler> handlers_;
+  AddressFilter address_filter_;
+  uint32_t diag_filtered_{0};
+  DedupCache *dedup_cache_{nullptr};
+  PublishPolicies publish_policies_;
+  uint32_t dedup_unique_{0};
+  uint32_t dedup_duplicates_{0};
+
+  bool priority_lane_enabled_{false};
+  uint8_t priority_status_mask_{PRIORITY_STATUS_MASK};
+  // Per summary window: frames by reason (a frame may count for several),
+  // and time from reception to the hand-over to MQTT
+  uint32_t priority_frames_{0};
+  uint32_t priority_alarm_{0};
+  uint32_t priority_installation_{0};
+  uint32_t priority_status_{0};
+  uint32_t priority_failed_{0};
+  uint64_t priority_latency_total_us_{0};
+  uint32_t priority_latency_max_us_{0};
+  void publish_priority_(Frame *frame, const Packet *p, uint8_t reasons);
+  MeterStats meter_stats_;
+  uint16_t meter_stats_capacity_{0};
+  uint8_t meter_stats_page_size_{10};
+  std::string meter_stats_topic_;
+  // Pages still to publish for the last request (one per loop())
+  size_t meter_stats_next_page_{0};
+  size_t meter_stats_end_page_{0};
+  void request_meter_stats_(const std::string &payload);
+  void publish_meter_stats_page_(uint32_t now_ms);
+
+  bool publish_queue_enabled_{false};
+  PublishQueue publish_queue_;
+  void publish_diagnostic_(const std::string &topic, const std::string &payload);
+
+  static constexpr const char *STORE_FORWARD_BASE_PATH = "/wmbus";
+  StoreForward store_forward_;
+  std::string store_forward_partition_;
+
+  TelegramPublisher publisher_;
+  // Next bridge sequence number (see Frame::sequence())
+  uint32_t frame_sequence_{0};
 
 
   // Diagnostics counters (published periodically if diagnostic_topic is set)
@@ -60,25 +242,21 @@ protected:
   // When false, per-packet payloads/logs omit the raw hex (much less spam)
   bool diag_publish_raw_{true};
 
-  enum DropBucket : uint8_t {
-    DB_TOO_SHORT = 0,
-    DB_DECODE_FAILED,
-    DB_DLL_CRC_STRIP_FAILED,
-    DB_UNKNOWN_PREAMBLE,
-    DB_L_FIELD_INVALID,
-    DB_UNKNOWN_LINK_MODE,
-    DB_OTHER,
-    DB_COUNT
-  };
-
   uint32_t diag_truncated_{0};
   uint32_t diag_dropped_{0};
-  std::array<uint32_t, DB_COUNT> diag_dropped_by_bucket_{};
+  std::array<uint32_t, (size_t) DropReason::COUNT> diag_dropped_by_reason_{};
   uint32_t last_diag_summary_ms_{0};
 
-  static DropBucket bucket_for_reason_(const std::string &reason);
+  void count_drop_(DropReason reason, uint32_t count = 1);
+  void handle_rejected_packet_(Packet *p);
   void maybe_publish_diag_summary_(uint32_t now_ms);
 
+  // Diagnostic payloads are rendered here, only when an event is published.
+  // The buffer keeps its capacity, so rendering does not allocate once warm.
+  std::string diag_payload_;
+  // Backing store for Frame::hex(), reused for every frame
+  std::string frame_text_;
+
   std::string diag_topic_{"wmbus/diag"};
 };
 } // namespace wmbus_radio
@@ -1,61 +1,75 @@
 #include "decode3of6.h"
 
-#include <map>
-
-#include "esphome/core/helpers.h"
-#include "esphome/core/log.h"
+#include <array>
 
 namespace esphome {
 namespace wmbus_radio {
-static const char *TAG = "3of6";
-std::optional<std::vector<uint8_t>>
-decode3of6(std::vector<uint8_t> &coded_data) {
+static constexpr uint8_t INVALID_SYMBOL = 0xFF;
+
+// Nibble -> 6-bit code
+static constexpr std::array<uint8_t, 16> CODES = {
+    0b010110, 0b001101, 0b001110, 0b001011, 0b011100, 0b011001, 0b011010, 0b010011,
+    0b101100, 0b100101, 0b100110, 0b100011, 0b110100, 0b110001, 0b110010, 0b101001,
+};
+
+// 6-bit code -> nibble, INVALID_SYMBOL for codes that are not 3-of-6 words.
+static constexpr std::array<uint8_t, 64> make_lookup_table() {
+  std::array<uint8_t, 64> table{};
+  for (auto &entry : table)
+    entry = INVALID_SYMBOL;
+  for (uint8_t nibble = 0; nibble < CODES.size(); nibble++)
+    table[CODES[nibble]] = nibble;
+  return table;
+}
 
-  static const std::map<uint8_t, uint8_t> lookupTable = {
-      {0b010110, 0x0}, {0b001101, 0x1}, {0b001110, 0x2}, {0b001011, 0x3},
-      {0b011100, 0x4}, {0b011001, 0x5}, {0b011010, 0x6}, {0b010011, 0x7},
-      {0b101100, 0x8}, {0b100101, 0x9}, {0b100110, 0xA}, {0b100011, 0xB},
-      {0b110100, 0xC}, {0b110001, 0xD}, {0b110010, 0xE}, {0b101001, 0xF},
-  };
+static constexpr auto LOOKUP_TABLE = make_lookup_table();
 
-  // ESP_LOGD(TAG, "Decoding 3of6 data: %s", format_hex(coded_data).c_str());
+static inline uint8_t symbol_at(const uint8_t *data, size_t len, size_t i) {
+  auto bit_idx = i * 6;
+  auto byte_idx = bit_idx / 8;
+  auto bit_offset = bit_idx % 8;
 
-  std::vector<uint8_t> decodedBytes;
+  uint8_t code = (data[byte_idx] << bit_offset);
+  if (bit_offset > 0) {
+    // Guard against out-of-bounds for the last symbol.
+    uint8_t next = 0;
+    if ((byte_idx + 1) < len)
+      next = data[byte_idx + 1];
+    code |= (next >> (8 - bit_offset));
+  }
+  return LOOKUP_TABLE[code >> 2];
+}
+
+size_t decode3of6(const uint8_t *coded, size_t coded_len, uint8_t *decoded) {
   // Number of 6-bit symbols that can be extracted from the coded buffer.
   // NOTE: decoding a symbol can span across byte boundary, so we must guard
   // against reading past the end of the buffer.
-  auto segments = coded_data.size() * 8 / 6;
-  auto data = coded_data.data();
-
-  for (size_t i = 0; i < segments; i++) {
-    auto bit_idx = i * 6;
-    auto byte_idx = bit_idx / 8;
-    auto bit_offset = bit_idx % 8;
+  const size_t segments = coded_len * 8 / 6;
+  size_t out = 0;
 
-    uint8_t code = (data[byte_idx] << bit_offset);
-    if (bit_offset > 0) {
-      // Guard against out-of-bounds for the last symbol.
-      uint8_t next = 0;
-      if ((byte_idx + 1) < coded_data.size())
-        next = data[byte_idx + 1];
-      code |= (next >> (8 - bit_offset));
-    }
-    code >>= 2;
-
-    auto it = lookupTable.find(code);
-    if (it == lookupTable.end()) {
-      // ESP_LOGW(TAG, "Invalid code: 0x%02X", code);
-      return {};
-    }
+  // Both symbols of a byte are read before it is written: byte k is stored
+  // only after coded bytes up to (12k + 11) / 8 were consumed, so writing in
+  // place never clobbers input that is still needed.
+  for (size_t i = 0; i + 1 < segments; i += 2) {
+    const uint8_t hi = symbol_at(coded, coded_len, i);
+    const uint8_t lo = symbol_at(coded, coded_len, i + 1);
+    if (hi == INVALID_SYMBOL || lo == INVALID_SYMBOL)
+      return 0;
+    if (decoded != nullptr)
+      decoded[out] = (hi << 4) | lo;
+    out++;
+  }
 
-    if (i % 2 == 0)
-      decodedBytes.push_back(it->second << 4);
-    else
-      decodedBytes.back() |= it->second;
+  if (segments % 2) {
+    const uint8_t hi = symbol_at(coded, coded_len, segments - 1);
+    if (hi == INVALID_SYMBOL)
+      return 0;
+    if (decoded != nullptr)
+      decoded[out] = hi << 4;
+    out++;
   }
 
-  // ESP_LOGV(TAG, "Successfully decoded %zu bytes", decodedBytes.size());
-  return decodedBytes;
+  return out;
 }
 
 size_t encoded_size(size_t decoded_size) {
@@ -63,5 +77,24 @@ size_t encoded_size(size_t decoded_size) {
   // bytes of coded data +1 for rounding up
   return (3 * decoded_size + 1) / 2;
 }
+
+size_t encode3of6(const uint8_t *data, size_t len, uint8_t *coded) {
+  // 12 bits per byte; whole coded bytes are written as soon as they are
+  // complete, so at most 7 bits wait in `bits` between two input bytes
+  uint32_t bits = 0;
+  unsigned pending = 0;
+  size_t out = 0;
+  for (size_t i = 0; i < len; i++) {
+    bits = (bits << 12) | (CODES[data[i] >> 4] << 6) | CODES[data[i] & 0x0F];
+    pending += 12;
+    while (pending >= 8) {
+      pending -= 8;
+      coded[out++] = (uint8_t) (bits >> pending);
+    }
+  }
+  if (pending > 0)
+    coded[out++] = (uint8_t) (bits << (8 - pending));
+  return out;
+}
 } // namespace wmbus_radio
-} // namespace esphome
\ No newline at end of file
+} // namespace esphome
@@ -1,13 +1,19 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
-#include <optional>
-#include <vector>
 
 namespace esphome {
 namespace wmbus_radio {
-std::optional<std::vector<uint8_t>>
-decode3of6(std::vector<uint8_t> &coded_data);
+// Decode 3-of-6 coded bytes. `decoded` may point to the same buffer as
+// `coded` (decoding in place is safe, output is always shorter than input).
+// With `decoded` == nullptr the input is only validated.
+// Returns number of decoded bytes or 0 if an invalid symbol was found.
+size_t decode3of6(const uint8_t *coded, size_t coded_len, uint8_t *decoded);
 size_t encoded_size(size_t decoded_size);
+// Encode `len` bytes into encoded_size(len) bytes of 3-of-6 code, the last
+// byte padded with zero bits. `coded` must not overlap `data`.
+// Returns the number of coded bytes.
+size_t encode3of6(const uint8_t *data, size_t len, uint8_t *coded);
 } // namespace wmbus_radio
-} // namespace esphome
\ No newline at end of file
+} // namespace esphome
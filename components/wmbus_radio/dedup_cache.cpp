@@ -0,0 +1,58 @@
+#include "dedup_cache.h"
+
+#include "esphome/core/log.h"
+
+namespace esphome {
+namespace wmbus_radio {
+static const char *const TAG = "wmbus_radio.dedup";
+
+void DedupCache::init() {
+  if (!this->entries_.empty())
+    return;
+  // Power of two so the home slot is a mask, at least one probe run
+  size_t size = PROBE_LENGTH;
+  while (size < this->capacity_)
+    size <<= 1;
+  this->entries_.assign(size, Entry{0, 0});
+  this->mask_ = size - 1;
+  ESP_LOGD(TAG, "Duplicate cache: %zu entries, window %u ms", size, (unsigned) this->window_ms_);
+}
+
+uint32_t DedupCache::hash(const uint8_t *data, size_t len) {
+  // FNV-1a
+  uint32_t h = 2166136261u;
+  for (size_t i = 0; i < len; i++) {
+    h ^= data[i];
+    h *= 16777619u;
+  }
+  return h != 0 ? h : 1;
+}
+
+bool DedupCache::check_and_insert(const uint8_t *data, size_t len, uint32_t now_ms) {
+  if (this->entries_.empty())
+    return false;
+
+  const uint32_t h = hash(data, len);
+  const size_t home = h & this->mask_;
+  Entry *victim = nullptr;
+  for (size_t i = 0; i < PROBE_LENGTH; i++) {
+    Entry &entry = this->entries_[(home + i) & this->mask_];
+    const bool live = this->is_live_(entry, now_ms);
+    if (live && entry.hash == h)
+      return true;
+    // Prefer a free slot, otherwise evict the oldest entry of the run
+    if (!live) {
+      if (victim == nullptr || this->is_live_(*victim, now_ms))
+        victim = &entry;
+    } else if (victim == nullptr ||
+               (this->is_live_(*victim, now_ms) && now_ms - entry.seen_ms > now_ms - victim->seen_ms)) {
+      victim = &entry;
+    }
+  }
+  victim->hash = h;
+  victim->seen_ms = now_ms;
+  return false;
+}
+
+} // namespace wmbus_radio
+} // namespace esphome
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace esphome {
+namespace wmbus_radio {
+
+// Remembers hashes of recently seen frames for `window_ms`. Fixed-size open
+// addressing: a hash lives in one of PROBE_LENGTH slots after its home slot,
+// so lookups are bounded and expired entries never need to be removed.
+// One cache is shared by all radios so a frame heard twice is caught too.
+class DedupCache {
+public:
+  DedupCache(size_t capacity, uint32_t window_ms) : capacity_(capacity), window_ms_(window_ms) {}
+
+  // Allocates the table (once; later calls do nothing)
+  void init();
+
+  // Returns true if the same bytes were seen less than window_ms ago.
+  // Otherwise remembers them. The window starts at the first sighting and
+  // is not extended by repeats, so an unchanged telegram still goes through
+  // once per window.
+  bool check_and_insert(const uint8_t *data, size_t len, uint32_t now_ms);
+
+  static uint32_t hash(const uint8_t *data, size_t len);
+
+protected:
+  static constexpr size_t PROBE_LENGTH = 8;
+
+  struct Entry {
+    uint32_t hash;  // 0: empty
+    uint32_t seen_ms;
+  };
+
+  bool is_live_(const Entry &entry, uint32_t now_ms) const {
+    return entry.hash != 0 && now_ms - entry.seen_ms < this->window_ms_;
+  }
+
+  size_t capacity_;
+  uint32_t window_ms_;
+  std::vector<Entry> entries_;
+  size_t mask_{0};
+};
+
+} // namespace wmbus_radio
+} // namespace esphome
@@ -0,0 +1,123 @@
+#include "delta_encoder.h"
+
+#include <cstring>
+
+#include "esphome/core/log.h"
+
+namespace esphome {
+namespace wmbus_radio {
+static const char *const TAG = "wmbus_radio.delta";
+
+void DeltaEncoder::init(size_t meters, uint8_t keyframe_interval) {
+  this->meters_.assign(meters, Meter{});
+  this->keyframe_interval_ = keyframe_interval;
+  ESP_LOGD(TAG, "Delta state for %zu meters (%zu bytes)", meters, meters * sizeof(Meter));
+}
+
+DeltaEncoder::Meter *DeltaEncoder::find_(uint16_t manufacturer, uint32_t id) {
+  Meter *oldest = nullptr;
+  for (auto &meter : this->meters_) {
+    if (meter.last_used != 0 && meter.manufacturer == manufacturer && meter.id == id)
+      return &meter;
+    if (oldest == nullptr || meter.last_used < oldest->last_used)
+      oldest = &meter;
+  }
+  if (oldest != nullptr) {
+    // New meter: its first message is a keyframe
+    oldest->manufacturer = manufacturer;
+    oldest->id = id;
+    oldest->last_used = 0;
+    oldest->sequence = 0;
+    oldest->since_keyframe = 0;
+    oldest->size = 0;
+  }
+  return oldest;
+}
+
+bool DeltaEncoder::encode_delta_(const uint8_t *base, size_t base_size, const uint8_t *data, size_t size,
+                                 uint8_t *out, size_t out_len, size_t &written) {
+  size_t n = 0;
+  size_t i = 0;
+  while (i < size) {
+    const auto diff = [&](size_t k) -> uint8_t { return data[k] ^ (k < base_size ? base[k] : 0); };
+    size_t run = 0;
+    while (i + run < size && run < 128 && diff(i + run) == 0)
+      run++;
+    if (run > 0) {
+      if (i + run == size)
+        break;  // trailing zeros are implied
+      if (n + 1 > out_len)
+        return false;
+      out[n++] = (uint8_t) (run - 1);
+      i += run;
+      continue;
+    }
+    // Literal run until two unchanged bytes in a row (one is cheaper inline)
+    while (i + run < size && run < 128 &&
+           (diff(i + run) != 0 || (i + run + 1 < size && diff(i + run + 1) != 0)))
+      run++;
+    if (n + 1 + run > out_len)
+      return false;
+    out[n++] = (uint8_t) (0x80 | (run - 1));
+    for (size_t k = 0; k < run; k++)
+      out[n++] = diff(i + k);
+    i += run;
+  }
+  written = n;
+  return true;
+}
+
+size_t DeltaEncoder::encode(Frame *frame, uint8_t *out, size_t out_len, bool force_keyframe) {
+  const uint8_t *data = frame->data();
+  const size_t size = frame->size();
+  const uint16_t manufacturer = frame->header().manufacturer;
+  const uint32_t id = frame->header().id;
+  if (size > MAX_FRAME_SIZE || out_len < HEADER_SIZE + size)
+    return 0;
+  Meter *meter = this->find_(manufacturer, id);
+  if (meter == nullptr)
+    return 0;
+
+  size_t body = 0;
+  // Forced, no state, a keyframe due, or a delta no smaller than the frame
+  // itself (e.g. encrypted data)
+  const bool keyframe = force_keyframe || meter->size == 0 ||
+                        meter->since_keyframe + 1 >= this->keyframe_interval_ ||
+                        !encode_delta_(meter->data, meter->size, data, size, out + HEADER_SIZE, size - 1, body);
+  if (keyframe) {
+    std::memcpy(out + HEADER_SIZE, data, size);
+    body = size;
+    meter->since_keyframe = 0;
+    this->keyframes_++;
+  } else {
+    meter->since_keyframe++;
+    this->deltas_++;
+  }
+
+  const uint16_t sequence = (uint16_t) frame->sequence();
+  const uint16_t base = keyframe ? sequence : meter->sequence;
+  uint8_t *p = out;
+  *p++ = keyframe ? TYPE_KEYFRAME : TYPE_DELTA;
+  *p++ = (uint8_t) (sequence >> 8);
+  *p++ = (uint8_t) sequence;
+  *p++ = (uint8_t) (base >> 8);
+  *p++ = (uint8_t) base;
+  *p++ = (uint8_t) (manufacturer >> 8);
+  *p++ = (uint8_t) manufacturer;
+  *p++ = (uint8_t) (id >> 24);
+  *p++ = (uint8_t) (id >> 16);
+  *p++ = (uint8_t) (id >> 8);
+  *p++ = (uint8_t) id;
+  *p++ = (uint8_t) frame->rssi();
+  *p++ = (uint8_t) (size >> 8);
+  *p++ = (uint8_t) size;
+
+  meter->sequence = sequence;
+  std::memcpy(meter->data, data, size);
+  meter->size = (uint16_t) size;
+  meter->last_used = ++this->clock_;
+  return HEADER_SIZE + body;
+}
+
+} // namespace wmbus_radio
+} // namespace esphome
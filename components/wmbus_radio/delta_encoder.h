@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "packet.h"
+
+namespace esphome {
+namespace wmbus_radio {
+
+// Encodes each meter's frame as a delta against the last frame published
+// for that meter. Message layout (multi-byte fields big-endian):
+//   0  u8   type: 'K' keyframe or 'D' delta
+//   1  u16  sequence: low 16 bits of the bridge sequence number
+//   3  u16  base: sequence of the message a delta applies to
+//           (keyframe: its own sequence)
+//   5  u16  manufacturer (M-field)
+//   7  u32  meter ID
+//   11 i8   RSSI [dBm]
+//   12 u16  frame length
+//   14 ...  keyframe: the frame bytes (same as as_raw())
+//           delta: the frame XOR the base frame (zero padded), run-length
+//           coded: 0x00-0x7F skips 1-128 unchanged bytes, 0x80-0xFF is
+//           followed by 1-128 literal XOR bytes. Trailing zeros are omitted.
+class DeltaEncoder {
+public:
+  static constexpr size_t HEADER_SIZE = 14;
+  static constexpr uint8_t TYPE_KEYFRAME = 'K';
+  static constexpr uint8_t TYPE_DELTA = 'D';
+  static constexpr size_t MAX_FRAME_SIZE = 256;
+
+  // Remembers up to `meters` meters (least recently published is
+  // replaced); every `keyframe_interval`-th message of a meter is a keyframe
+  void init(size_t meters, uint8_t keyframe_interval);
+
+  // Room needed for a message about `frame`
+  static size_t buffer_size(const Frame &frame) { return HEADER_SIZE + frame.size() + frame.size() / 128 + 1; }
+  // Returns the message length, or 0 if the frame can't be encoded. A forced
+  // keyframe does not depend on messages that may still be on their way.
+  size_t encode(Frame *frame, uint8_t *out, size_t out_len, bool force_keyframe = false);
+
+  uint32_t keyframes() const { return this->keyframes_; }
+  uint32_t deltas() const { return this->deltas_; }
+
+protected:
+  struct Meter {
+    uint16_t manufacturer;
+    uint32_t id;
+    uint32_t last_used;  // 0: slot free
+    uint16_t sequence;  // of the last message
+    uint8_t since_keyframe;
+    uint16_t size;
+    uint8_t data[MAX_FRAME_SIZE];
+  };
+
+  Meter *find_(uint16_t manufacturer, uint32_t id);
+  // False if the delta does not fit in out_len
+  static bool encode_delta_(const uint8_t *base, size_t base_size, const uint8_t *data, size_t size, uint8_t *out,
+                            size_t out_len, size_t &written);
+
+  std::vector<Meter> meters_;
+  uint8_t keyframe_interval_{10};
+  uint32_t clock_{0};
+  uint32_t keyframes_{0};
+  uint32_t deltas_{0};
+};
+
+} // namespace wmbus_radio
+} // namespace esphome
@@ -0,0 +1,169 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// In-place DLL CRC handling for the radio packet path. Same rules as
+// wmbus_bridge_common/dll_crc.h, but working on the packet buffer directly
+// so wmbus_radio stays usable without any other component.
+
+namespace esphome {
+namespace wmbus_radio {
+
+// EN 13757 CRC16 used in wM-Bus DLL
+static constexpr uint16_t CRC16_EN_13757_POLY = 0x3D65;
+
+inline uint16_t crc16_en13757(const uint8_t *data, size_t len) {
+  uint16_t crc = 0x0000;
+  for (size_t i = 0; i < len; i++) {
+    uint8_t b = data[i];
+    for (int bit = 0; bit < 8; bit++) {
+      if ((((crc & 0x8000) >> 8) ^ (b & 0x80)) != 0) {
+        crc = (uint16_t)((crc << 1) ^ CRC16_EN_13757_POLY);
+      } else {
+        crc = (uint16_t)(crc << 1);
+      }
+      b <<= 1;
+    }
+  }
+  return (uint16_t)(~crc);
+}
+
+// True if the 2 big-endian bytes at data[len] hold the CRC of data[0..len)
+inline bool dll_crc_ok(const uint8_t *data, size_t len) {
+  return crc16_en13757(data, len) == (uint16_t)(data[len] << 8 | data[len + 1]);
+}
+
+enum class DllCrcResult : uint8_t {
+  OK = 0,
+  TOO_SHORT,  // buffer holds fewer bytes than the L-field announces
+  MISMATCH,   // a block CRC does not match (or block layout is impossible)
+};
+
+// Frame Format A: first block 10 bytes, then blocks of up to 16 bytes, each
+// followed by its own CRC. L-field excludes the CRC bytes.
+inline size_t dll_size_format_a(uint8_t l_field) {
+  const size_t data_len = (size_t) l_field + 1;
+  if (data_len <= 10)
+    return data_len + 2;
+  return data_len + 2 + 2 * ((data_len - 10 + 15) / 16);
+}
+
+// Verify and remove all Format A block CRCs. On success len is L+1.
+// The buffer is left untouched unless every CRC matches.
+inline DllCrcResult strip_dll_crc_format_a(uint8_t *data, size_t &len) {
+  if (len == 0)
+    return DllCrcResult::TOO_SHORT;
+  const size_t want = (size_t) data[0] + 1;
+  const size_t full = dll_size_format_a(data[0]);
+  if (len < full)
+    return DllCrcResult::TOO_SHORT;
+
+  for (size_t pos = 0, done = 0; done < want;) {
+    const size_t take = std::min<size_t>(want - done, done == 0 ? 10 : 16);
+    if (!dll_crc_ok(data + pos, take))
+      return DllCrcResult::MISMATCH;
+    pos += take + 2;
+    done += take;
+  }
+
+  // Blocks only ever move towards the start, so the write position never
+  // overtakes the read position.
+  for (size_t pos = 10 + 2, out = 10; out < want;) {
+    const size_t take = std::min<size_t>(want - out, 16);
+    std::memmove(data + out, data + pos, take);
+    pos += take + 2;
+    out += take;
+  }
+
+  len = want;
+  return DllCrcResult::OK;
+}
+
+// Frame Format B: L-field includes the CRC bytes. CRC1 covers the first
+// (up to) 126 bytes; frames longer than 128 bytes carry CRC2 at the end.
+// On success the CRCs are removed and the L-field is fixed up so the result
+// looks like a Format A frame with CRCs stripped.
+inline DllCrcResult strip_dll_crc_format_b(uint8_t *data, size_t &len) {
+  if (len == 0)
+    return DllCrcResult::TOO_SHORT;
+  const size_t total = (size_t) data[0] + 1;
+  if (len < total)
+    return DllCrcResult::TOO_SHORT;
+  if (total < 12)
+    return DllCrcResult::MISMATCH;
+
+  if (total <= 128) {
+    if (!dll_crc_ok(data, total - 2))
+      return DllCrcResult::MISMATCH;
+    len = total - 2;
+  } else {
+    // Block 3 must carry at least one data byte besides CRC2
+    if (total < 128 + 3)
+      return DllCrcResult::MISMATCH;
+    if (!dll_crc_ok(data, 126) || !dll_crc_ok(data + 128, total - 128 - 2))
+      return DllCrcResult::MISMATCH;
+    std::memmove(data + 126, data + 128, total - 128 - 2);
+    len = total - 4;
+  }
+
+  data[0] = (uint8_t)(len - 1);
+  return DllCrcResult::OK;
+}
+
+// Store the big-endian CRC of data[0..len) at data[len]
+inline void put_dll_crc(uint8_t *data, size_t len) {
+  const uint16_t crc = crc16_en13757(data, len);
+  data[len] = (uint8_t)(crc >> 8);
+  data[len + 1] = (uint8_t)crc;
+}
+
+// Reverse of strip_dll_crc_format_a: copy the L+1 bytes of `frame` to `out`
+// (which must not overlap it) with a CRC after every block. `out` needs
+// dll_size_format_a(frame[0]) bytes. Returns that size, or 0 if `len` does
+// not match the L-field.
+inline size_t insert_dll_crc_format_a(const uint8_t *frame, size_t len, uint8_t *out) {
+  if (len == 0 || len != (size_t) frame[0] + 1)
+    return 0;
+  size_t pos = 0;
+  for (size_t done = 0; done < len;) {
+    const size_t take = std::min<size_t>(len - done, done == 0 ? 10 : 16);
+    std::memcpy(out + pos, frame + done, take);
+    put_dll_crc(out + pos, take);
+    pos += take + 2;
+    done += take;
+  }
+  return pos;
+}
+
+// Size of a Format B frame carrying `len` bytes (L+1 without CRCs)
+inline size_t dll_size_format_b(size_t len) { return len <= 126 ? len + 2 : len + 4; }
+
+// Reverse of strip_dll_crc_format_b: `frame` is L+1 bytes with a Format A
+// style L-field, which is rewritten to count the CRCs. `out` (not
+// overlapping `frame`) needs dll_size_format_b(len) bytes. Returns that
+// size, or 0 if `len` does not match the L-field or is too long for an
+// 8-bit L-field.
+inline size_t insert_dll_crc_format_b(const uint8_t *frame, size_t len, uint8_t *out) {
+  if (len < 10 || len != (size_t) frame[0] + 1)
+    return 0;
+  const size_t total = dll_size_format_b(len);
+  if (total > 256)
+    return 0;
+  if (len <= 126) {
+    std::memcpy(out, frame, len);
+    out[0] = (uint8_t)(total - 1);
+    put_dll_crc(out, len);
+  } else {
+    std::memcpy(out, frame, 126);
+    out[0] = (uint8_t)(total - 1);
+    put_dll_crc(out, 126);
+    std::memcpy(out + 128, frame + 126, len - 126);
+    put_dll_crc(out + 128, len - 126);
+  }
+  return total;
+}
+
+}  // namespace wmbus_radio
+}  // namespace esphome
@@ -0,0 +1,97 @@
+#include "frame_encoder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "decode3of6.h"
+#include "dll_crc.h"
+
+#define WMBUS_MODE_C_PREAMBLE (0x54)
+#define WMBUS_BLOCK_A_PREAMBLE (0xCD)
+#define WMBUS_BLOCK_B_PREAMBLE (0x3D)
+#define WMBUS_MODE_C_PREFIX_SIZE (2)
+
+namespace esphome {
+namespace wmbus_radio {
+
+// Format B counts the CRCs in its 8-bit L-field
+static constexpr size_t MAX_FRAME_SIZE_B = 252;
+// Frame with the most CRCs: 256 bytes in 17 blocks
+static constexpr size_t MAX_DLL_SIZE = 256 + 2 * 17;
+
+size_t max_frame_size(FrameFormat format) { return format == FrameFormat::A ? 256 : MAX_FRAME_SIZE_B; }
+
+size_t encoded_packet_size(size_t len, LinkMode mode, FrameFormat format) {
+  if (len == 0 || len > max_frame_size(format) || (format == FrameFormat::B && len < 10))
+    return 0;
+  const size_t dll_size =
+      format == FrameFormat::A ? dll_size_format_a((uint8_t) (len - 1)) : dll_size_format_b(len);
+  switch (mode) {
+    case LinkMode::T1:
+      return encoded_size(dll_size);
+    case LinkMode::C1:
+      return WMBUS_MODE_C_PREFIX_SIZE + dll_size;
+    default:
+      return 0;
+  }
+}
+
+static size_t insert_dll_crc(const uint8_t *frame, size_t len, FrameFormat format, uint8_t *out) {
+  if (format == FrameFormat::A)
+    return insert_dll_crc_format_a(frame, len, out);
+  return insert_dll_crc_format_b(frame, len, out);
+}
+
+size_t encode_packet(const uint8_t *frame, size_t len, LinkMode mode, FrameFormat format, uint8_t *out,
+                     size_t out_len) {
+  const size_t size = encoded_packet_size(len, mode, format);
+  if (size == 0 || size > out_len || frame[0] != len - 1)
+    return 0;
+
+  if (mode == LinkMode::C1) {
+    out[0] = WMBUS_MODE_C_PREAMBLE;
+    out[1] = format == FrameFormat::A ? WMBUS_BLOCK_A_PREAMBLE : WMBUS_BLOCK_B_PREAMBLE;
+    insert_dll_crc(frame, len, format, out + WMBUS_MODE_C_PREFIX_SIZE);
+    return size;
+  }
+
+  // T1: the CRCs are coded too
+  uint8_t dll[MAX_DLL_SIZE];
+  return encode3of6(dll, insert_dll_crc(frame, len, format, dll), out);
+}
+
+static uint32_t xorshift32(uint32_t &state) {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+size_t inject_bit_errors(uint8_t *data, size_t len, double ber, uint32_t &state) {
+  if (ber <= 0.0 || len == 0)
+    return 0;
+  if (state == 0)
+    state = 1;
+  const size_t bits = len * 8;
+  if (ber >= 1.0) {
+    for (size_t i = 0; i < len; i++)
+      data[i] = ~data[i];
+    return bits;
+  }
+  // Jump straight to the next flipped bit: the gap is geometrically distributed
+  const double log_keep = std::log1p(-ber);
+  const auto gap = [&]() {
+    const double u = (xorshift32(state) >> 8) * (1.0 / 16777216.0);
+    return (size_t) std::min(std::log1p(-u) / log_keep, (double) bits);
+  };
+  size_t flipped = 0;
+  for (size_t bit = gap(); bit < bits; bit += 1 + gap()) {
+    flip_bit(data, bit);
+    flipped++;
+  }
+  return flipped;
+}
+
+} // namespace wmbus_radio
+} // namespace esphome
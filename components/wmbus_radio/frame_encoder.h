@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "link_mode.h"
+
+namespace esphome {
+namespace wmbus_radio {
+
+// Builds on-air packets from frames, the reverse of
+// Packet::convert_to_frame(): DLL CRCs for frame format A or B, then 3-of-6
+// coding for T1 or the 0x54 0xCD / 0x54 0x3D prefix for C1. The receive
+// path does not use it; it is for generating test traffic.
+
+enum class FrameFormat : uint8_t { A, B };
+
+// Largest frame (L-field + 1, without CRCs) the format can carry
+size_t max_frame_size(FrameFormat format);
+
+// Size of the packet encode_packet() builds for a frame of `len` bytes,
+// 0 if the format cannot carry it
+size_t encoded_packet_size(size_t len, LinkMode mode, FrameFormat format);
+
+// Writes the packet for `frame` (L-field + 1 bytes without CRCs, as
+// Frame::data() returns it) to `out`, as a transceiver would deliver it.
+// Returns its size, or 0 if the L-field does not match `len`, the format
+// cannot carry the frame or `out_len` is too small.
+size_t encode_packet(const uint8_t *frame, size_t len, LinkMode mode, FrameFormat format, uint8_t *out,
+                     size_t out_len);
+
+// Flips one bit; bit 0 is the most significant bit of data[0], the first
+// one on air
+inline void flip_bit(uint8_t *data, size_t bit) { data[bit / 8] ^= 0x80 >> (bit % 8); }
+
+// Flips every bit with probability `ber` and returns how many were flipped.
+// `state` is a xorshift32 state (any non-zero value), advanced by the call,
+// so the same seed gives the same errors.
+size_t inject_bit_errors(uint8_t *data, size_t len, double ber, uint32_t &state);
+
+} // namespace wmbus_radio
+} // namespace esphome
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "link_mode.h"
+#include "packet.h"
+
+namespace esphome {
+namespace wmbus_radio {
+
+// Declarative on_frame conditions, checked against the parsed header before
+// the automation runs. Fields left at their defaults match every frame.
+struct FrameFilter {
+  LinkMode link_mode{LinkMode::UNKNOWN};
+  int8_t min_rssi{-128};
+  uint16_t manufacturer{0};
+  // BCD ID under a nibble mask: "1234****" is 0x12340000 / 0xFFFF0000
+  uint32_t id_value{0};
+  uint32_t id_mask{0};
+  std::vector<uint8_t> ci;  // empty: any
+
+  bool matches(Frame *frame) const {
+    const auto &header = frame->header();
+    if (this->link_mode != LinkMode::UNKNOWN && frame->link_mode() != this->link_mode)
+      return false;
+    if (frame->rssi() < this->min_rssi)
+      return false;
+    if (this->manufacturer != 0 && header.manufacturer != this->manufacturer)
+      return false;
+    if ((header.id & this->id_mask) != this->id_value)
+      return false;
+    if (this->ci.empty())
+      return true;
+    for (const uint8_t ci : this->ci) {
+      if (header.ci == ci)
+        return true;
+    }
+    return false;
+  }
+};
+
+} // namespace wmbus_radio
+} // namespace esphome
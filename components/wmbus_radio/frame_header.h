@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+namespace esphome {
+namespace wmbus_radio {
+
+// Link layer header of a decoded frame (L-field first, DLL CRCs removed),
+// read from fixed positions: L, C, M (2), ID (4), version, type, CI.
+// Kept free of wmbus_common: this is all the bridge needs for routing.
+struct FrameHeader {
+  uint8_t c_field{0};
+  uint16_t manufacturer{0};  // M-field
+  uint32_t id{0};            // BCD: meter "12345678" is 0x12345678
+  uint8_t version{0};
+  uint8_t device_type{0};
+  uint8_t ci{0};  // 0 if the frame ends before it
+  // Three-letter manufacturer code, e.g. "KAM"
+  char manufacturer_code[4]{};
+
+  // False (and nothing set) if the frame is too short to hold the address
+  bool parse(const uint8_t *frame, size_t len) {
+    if (len < 10)
+      return false;
+    this->c_field = frame[1];
+    this->manufacturer = frame[2] | (uint16_t) frame[3] << 8;
+    this->id = frame[4] | (uint32_t) frame[5] << 8 | (uint32_t) frame[6] << 16 | (uint32_t) frame[7] << 24;
+    this->version = frame[8];
+    this->device_type = frame[9];
+    this->ci = len > 10 ? frame[10] : 0;
+    this->manufacturer_code[0] = (char) (64 + ((this->manufacturer >> 10) & 0x1F));
+    this->manufacturer_code[1] = (char) (64 + ((this->manufacturer >> 5) & 0x1F));
+    this->manufacturer_code[2] = (char) (64 + (this->manufacturer & 0x1F));
+    this->manufacturer_code[3] = '\0';
+    return true;
+  }
+};
+
+inline uint64_t meter_key(uint16_t manufacturer, uint32_t id) { return (uint64_t) manufacturer << 32 | id; }
+
+// "KAM:12345678" (or "12345678" for manufacturer 0); `out` holds 13 chars
+inline void format_meter_address(uint16_t manufacturer, uint32_t id, char *out) {
+  if (manufacturer == 0) {
+    snprintf(out, 13, "%08x", (unsigned) id);
+    return;
+  }
+  snprintf(out, 13, "%c%c%c:%08x", (char) (64 + ((manufacturer >> 10) & 0x1F)),
+           (char) (64 + ((manufacturer >> 5) & 0x1F)), (char) (64 + (manufacturer & 0x1F)), (unsigned) id);
+}
+
+// Extended and transport layer headers in front of the application data
+struct TplInfo {
+  // Access number, counted up by the meter for every telegram
+  bool has_access_number{false};
+  uint8_t access_number{0};
+  // Status byte of the transport layer header (EN 13757-3)
+  bool has_status{false};
+  uint8_t status{0};
+  // CI-field past the ELL, if any (0 if encrypted by the ELL or cut short)
+  uint8_t ci{0};
+  // Start of the application data (past ACC, status, configuration and,
+  // for ELL, the payload CRC). Encrypted data is still encrypted.
+  size_t payload_offset{0};
+};
+
+// Walks the ELL/TPL headers starting at the CI-field (offset 10). The access
+// number of the transport layer is preferred over the one of the ELL.
+inline TplInfo parse_tpl_header(const uint8_t *frame, size_t len) {
+  TplInfo info;
+  size_t ci = 10;
+  while (ci < len) {
+    switch (frame[ci]) {
+      case 0x8C:  // ELL I: CC, ACC
+      case 0x8D:  // ELL II: CC, ACC, SN (4), payload CRC (2)
+        if (ci + 3 > len)
+          break;
+        info.has_access_number = true;
+        info.access_number = frame[ci + 2];
+        if (frame[ci] == 0x8D) {
+          // Anything past the payload CRC is encrypted by the ELL
+          info.payload_offset = ci + 9 <= len ? ci + 9 : len;
+          return info;
+        }
+        ci += 3;
+        continue;
+      case 0x7A:  // short TPL header: ACC, status, configuration (2)
+        if (ci + 5 > len)
+          break;
+        info.ci = frame[ci];
+        info.has_access_number = true;
+        info.access_number = frame[ci + 1];
+        info.has_status = true;
+        info.status = frame[ci + 2];
+        info.payload_offset = ci + 5;
+        return info;
+      case 0x72:  // long TPL header: ID (4), M (2), version, type, ACC, status, configuration (2)
+        if (ci + 13 > len)
+          break;
+        info.ci = frame[ci];
+        info.has_access_number = true;
+        info.access_number = frame[ci + 9];
+        info.has_status = true;
+        info.status = frame[ci + 10];
+        info.payload_offset = ci + 13;
+        return info;
+      default:  // no TPL header (0x78 and others)
+        info.ci = frame[ci];
+        info.payload_offset = ci + 1;
+        return info;
+    }
+    break;
+  }
+  // Header cut short: no application data
+  info.payload_offset = len;
+  return info;
+}
+
+// Why a frame is urgent (bit set): alarms and installation requests skip the
+// queues in front of the MQTT publish, see Radio::set_priority_lane()
+enum PriorityReason : uint8_t {
+  PRIORITY_ALARM = 1 << 0,         // CI 0x71: alarm protocol
+  PRIORITY_INSTALLATION = 1 << 1,  // C-field 0x46: SND_IR, installation request
+  PRIORITY_STATUS = 1 << 2,        // TPL status bits in `status_mask` set
+};
+
+// Default status bits: power low, permanent error, temporary error
+static constexpr uint8_t PRIORITY_STATUS_MASK = 0x1C;
+
+inline uint8_t priority_reasons(const FrameHeader &header, const uint8_t *frame, size_t len, uint8_t status_mask) {
+  uint8_t reasons = 0;
+  if (header.c_field == 0x46)
+    reasons |= PRIORITY_INSTALLATION;
+  const TplInfo tpl = parse_tpl_header(frame, len);
+  if (tpl.ci == 0x71)
+    reasons |= PRIORITY_ALARM;
+  if (tpl.has_status && (tpl.status & status_mask) != 0)
+    reasons |= PRIORITY_STATUS;
+  return reasons;
+}
+
+} // namespace wmbus_radio
+} // namespace esphome
@@ -0,0 +1,185 @@
+#include "meter_stats.h"
+
+#include <algorithm>
+
+#include "esphome/core/helpers.h"
+#include "esphome/core/log.h"
+
+namespace esphome {
+namespace wmbus_radio {
+static const char *const TAG = "wmbus_radio.stats";
+
+// Weight of a new RSSI sample in rssi_avg
+static constexpr float RSSI_EWMA_ALPHA = 0.125f;
+// An access number this far ahead is taken as the meter's counter jumping
+// (reset, reordering) rather than that many lost telegrams
+static constexpr uint8_t MAX_ACCESS_NUMBER_GAP = 128;
+
+bool MeterStats::init(size_t capacity) {
+  if (capacity == 0 || capacity > MAX_CAPACITY || this->entries_ != nullptr)
+    return false;
+
+  size_t slots = 1;
+  while (slots < 2 * capacity)
+    slots <<= 1;
+
+  // PSRAM is preferred when available
+  RAMAllocator<Entry> entry_allocator;
+  RAMAllocator<uint16_t> slot_allocator;
+  this->entries_ = entry_allocator.allocate(capacity);
+  this->slots_ = slot_allocator.allocate(slots);
+  if (this->entries_ == nullptr || this->slots_ == nullptr) {
+    ESP_LOGE(TAG, "Cannot allocate statistics for %zu meters", capacity);
+    if (this->entries_ != nullptr)
+      entry_allocator.deallocate(this->entries_, capacity);
+    if (this->slots_ != nullptr)
+      slot_allocator.deallocate(this->slots_, slots);
+    this->entries_ = nullptr;
+    this->slots_ = nullptr;
+    return false;
+  }
+  std::fill(this->slots_, this->slots_ + slots, NIL);
+  this->capacity_ = capacity;
+  this->mask_ = slots - 1;
+
+  ESP_LOGD(TAG, "Statistics for up to %zu meters (%zu bytes)", capacity,
+           capacity * sizeof(Entry) + slots * sizeof(uint16_t));
+  return true;
+}
+
+size_t MeterStats::home_(uint16_t manufacturer, uint32_t id) const {
+  return (size_t) ((meter_key(manufacturer, id) * 0x9E3779B97F4A7C15ull) >> 40) & this->mask_;
+}
+
+size_t MeterStats::find_slot_(uint16_t manufacturer, uint32_t id) const {
+  size_t slot = this->home_(manufacturer, id);
+  while (this->slots_[slot] != NIL) {
+    const Entry &entry = this->entries_[this->slots_[slot]];
+    if (entry.id == id && entry.manufacturer == manufacturer)
+      break;
+    slot = (slot + 1) & this->mask_;
+  }
+  return slot;
+}
+
+void MeterStats::unlink_(uint16_t index) {
+  Entry &entry = this->entries_[index];
+  if (entry.newer != NIL)
+    this->entries_[entry.newer].older = entry.older;
+  else
+    this->newest_ = entry.older;
+  if (entry.older != NIL)
+    this->entries_[entry.older].newer = entry.newer;
+  else
+    this->oldest_ = entry.newer;
+}
+
+void MeterStats::push_newest_(uint16_t index) {
+  Entry &entry = this->entries_[index];
+  entry.newer = NIL;
+  entry.older = this->newest_;
+  if (this->newest_ != NIL)
+    this->entries_[this->newest_].newer = index;
+  this->newest_ = index;
+  if (this->oldest_ == NIL)
+    this->oldest_ = index;
+}
+
+void MeterStats::remove_from_index_(size_t slot) {
+  // Backward-shift deletion: pull later members of the probe run into the
+  // hole so lookups never need tombstones
+  size_t hole = slot;
+  for (size_t next = (slot + 1) & this->mask_; this->slots_[next] != NIL; next = (next + 1) & this->mask_) {
+    const Entry &entry = this->entries_[this->slots_[next]];
+    const size_t home = this->home_(entry.manufacturer, entry.id);
+    // Move it unless its home lies cyclically in (hole, next]
+    const bool stays = hole <= next ? (home > hole && home <= next) : (home > hole || home <= next);
+    if (!stays) {
+      this->slots_[hole] = this->slots_[next];
+      hole = next;
+    }
+  }
+  this->slots_[hole] = NIL;
+}
+
+void MeterStats::track_access_number_(Entry &entry, const uint8_t *frame, size_t len) {
+  const TplInfo tpl = parse_tpl_header(frame, len);
+  if (!tpl.has_access_number)
+    return;
+
+  uint32_t expected = 1;
+  if (entry.has_access_number) {
+    const uint8_t gap = tpl.access_number - entry.last_access_number;
+    // Same number again: a repeat of the telegram already counted
+    if (gap == 0)
+      return;
+    if (gap <= MAX_ACCESS_NUMBER_GAP)
+      expected = gap;
+  }
+  entry.has_access_number = true;
+  entry.last_access_number = tpl.access_number;
+  entry.acc_received++;
+  entry.acc_expected += expected;
+  this->window_received_++;
+  this->window_expected_ += expected;
+}
+
+void MeterStats::record(const FrameHeader &header, const uint8_t *frame, size_t len, int8_t rssi,
+                        LinkMode link_mode, uint32_t now_ms) {
+  if (this->entries_ == nullptr)
+    return;
+  const uint16_t manufacturer = header.manufacturer;
+  const uint32_t id = header.id;
+
+  size_t slot = this->find_slot_(manufacturer, id);
+  uint16_t index = this->slots_[slot];
+  if (index != NIL) {
+    Entry &entry = this->entries_[index];
+    const float interval = (float) (now_ms - entry.last_seen_ms);
+    entry.frames++;
+    entry.mean_interval_ms += (interval - entry.mean_interval_ms) / (float) (entry.frames - 1);
+    entry.last_seen_ms = now_ms;
+    entry.rssi_avg += RSSI_EWMA_ALPHA * ((float) rssi - entry.rssi_avg);
+    entry.rssi_last = rssi;
+    entry.rssi_min = std::min(entry.rssi_min, rssi);
+    entry.rssi_max = std::max(entry.rssi_max, rssi);
+    entry.link_mode = link_mode;
+    this->track_access_number_(entry, frame, len);
+    this->unlink_(index);
+    this->push_newest_(index);
+    return;
+  }
+
+  if (this->count_ < this->capacity_) {
+    index = (uint16_t) this->count_++;
+  } else {
+    // Reuse the entry of the meter heard least recently
+    index = this->oldest_;
+    const Entry &victim = this->entries_[index];
+    this->remove_from_index_(this->find_slot_(victim.manufacturer, victim.id));
+    this->unlink_(index);
+    this->evictions_++;
+    slot = this->find_slot_(manufacturer, id);
+  }
+
+  Entry &entry = this->entries_[index];
+  entry.manufacturer = manufacturer;
+  entry.id = id;
+  entry.frames = 1;
+  entry.last_seen_ms = now_ms;
+  entry.mean_interval_ms = 0.0f;
+  entry.rssi_avg = rssi;
+  entry.rssi_last = rssi;
+  entry.rssi_min = rssi;
+  entry.rssi_max = rssi;
+  entry.link_mode = link_mode;
+  entry.acc_received = 0;
+  entry.acc_expected = 0;
+  entry.has_access_number = false;
+  this->track_access_number_(entry, frame, len);
+  this->slots_[slot] = index;
+  this->push_newest_(index);
+}
+
+} // namespace wmbus_radio
+} // namespace esphome
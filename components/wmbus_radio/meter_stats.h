@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "frame_header.h"
+#include "link_mode.h"
+
+namespace esphome {
+namespace wmbus_radio {
+
+// Reception statistics per meter in a table of fixed capacity. Entries are
+// found through an open-addressed index (linear probing) and kept in LRU
+// order, so when the table is full the meter heard least recently makes
+// room. All memory is allocated in init(); record() never allocates.
+class MeterStats {
+public:
+  struct Entry {
+    uint16_t manufacturer;
+    uint32_t id;
+    uint32_t frames;
+    uint32_t last_seen_ms;
+    float mean_interval_ms;
+    float rssi_avg;  // EWMA
+    int8_t rssi_last;
+    int8_t rssi_min;
+    int8_t rssi_max;
+    LinkMode link_mode;
+
+    // Telegrams received and expected judging by the access number (ACC),
+    // which the meter counts up with every transmission
+    uint32_t acc_received;
+    uint32_t acc_expected;
+    uint8_t last_access_number;
+    bool has_access_number;
+
+    // LRU list (indices into the entry array)
+    uint16_t newer;
+    uint16_t older;
+  };
+
+  static constexpr size_t MAX_CAPACITY = 4096;
+
+  bool init(size_t capacity);
+  bool is_enabled() const { return this->entries_ != nullptr; }
+
+  // `frame` is a decoded frame (L-field first, DLL CRCs removed)
+  void record(const FrameHeader &header, const uint8_t *frame, size_t len, int8_t rssi, LinkMode link_mode,
+              uint32_t now_ms);
+
+  // Meters currently in the table, in no particular order
+  size_t size() const { return this->count_; }
+  const Entry &entry(size_t index) const { return this->entries_[index]; }
+  uint32_t evictions() const { return this->evictions_; }
+
+  // Access number totals over all meters since reset_window()
+  uint32_t window_received() const { return this->window_received_; }
+  uint32_t window_expected() const { return this->window_expected_; }
+  void reset_window() {
+    this->window_received_ = 0;
+    this->window_expected_ = 0;
+  }
+
+protected:
+  static constexpr uint16_t NIL = 0xFFFF;
+
+  size_t home_(uint16_t manufacturer, uint32_t id) const;
+  size_t find_slot_(uint16_t manufacturer, uint32_t id) const;
+  void unlink_(uint16_t index);
+  void push_newest_(uint16_t index);
+  void remove_from_index_(size_t slot);
+  void track_access_number_(Entry &entry, const uint8_t *frame, size_t len);
+
+  Entry *entries_{nullptr};
+  size_t capacity_{0};
+  size_t count_{0};
+  // Index slots hold entry indices (NIL: free); twice the capacity so
+  // probe runs stay short
+  uint16_t *slots_{nullptr};
+  size_t mask_{0};
+  uint16_t newest_{NIL};
+  uint16_t oldest_{NIL};
+  uint32_t evictions_{0};
+  uint32_t window_received_{0};
+  uint32_t window_expected_{0};
+};
+
+} // namespace wmbus_radio
+} // namespace esphome
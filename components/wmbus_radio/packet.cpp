@@ -1,12 +1,18 @@
 #include "packet.h"
 
 #include <algorithm>
+#include <cstdio>
+#include <cstring>
 #include <ctime>
+#include <sys/time.h>
+
+#include "esp_timer.h"
 
 #include "esphome/core/log.h"
 #include "esphome/core/helpers.h"
 
 #include "decode3of6.h"
+#include "dll_crc.h"
 
 #define WMBUS_PREAMBLE_SIZE (3)
 #define WMBUS_MODE_C_SUFIX_LEN (2)
@@ -19,49 +25,129 @@ namespace wmbus_radio {
 
 static const char *const TAG = "wmbus_radio.packet";
 
-// Hex-encode up to max_bytes from input. Result contains only 0-9a-f.
-static std::string hex_prefix_(const std::vector<uint8_t> &in, size_t max_bytes) {
-  const size_t n = (max_bytes == 0) ? in.size() : std::min(in.size(), max_bytes);
-  std::string out;
-  out.reserve(n * 2);
+// Lowercase hex of `len` bytes into `out` (2 * len chars, no terminator)
+static void write_hex_chars(const uint8_t *data, size_t len, char *out) {
   static const char *hex = "0123456789abcdef";
-  for (size_t i = 0; i < n; i++) {
-    uint8_t b = in[i];
-    out.push_back(hex[b >> 4]);
-    out.push_back(hex[b & 0x0F]);
+  for (size_t i = 0; i < len; i++) {
+    *out++ = hex[data[i] >> 4];
+    *out++ = hex[data[i] & 0x0F];
   }
+}
+
+// T1 carries no format marker. The first block (L, C, M, A) is laid out the
+// same in both formats, and only format A has a CRC right after it. That
+// CRC matches a format B frame by chance once in 65536 frames, so format A
+// also needs the CRC of its second block to match. `coded` is the 3-of-6
+// coded packet of `coded_len` bytes, `head` its first 12 decoded bytes.
+static bool t1_is_format_a(const uint8_t *coded, size_t coded_len, const uint8_t *head) {
+  if (!dll_crc_ok(head, 10))
+    return false;
+  // L >= 11 here, so format A always has a second block
+  const size_t l_want = (size_t) head[0] + 1;
+  const size_t block2 = std::min<size_t>(l_want - 10, 16);
+  uint8_t blocks[10 + 2 + 16 + 2];
+  const size_t blocks_len = 10 + 2 + block2 + 2;
+  if (encoded_size(blocks_len) > coded_len) {
+    // Too short for format A anyway: report it as such unless it fits as B
+    return encoded_size(l_want) > coded_len;
+  }
+  if (decode3of6(coded, encoded_size(blocks_len), blocks) != blocks_len)
+    return false;
+  return dll_crc_ok(blocks + 12, block2);
+}
+
+static uint8_t *put_be(uint8_t *out, uint64_t value, size_t bytes) {
+  for (size_t i = bytes; i-- > 0;)
+    *out++ = (uint8_t) (value >> (8 * i));
   return out;
 }
 
-Packet::Packet() { this->data_.reserve(WMBUS_PREAMBLE_SIZE); }
+// Minimal CBOR (RFC 8949) writer: just the item types the envelope uses.
+// Every value is written in its shortest form, as the spec recommends.
+static uint8_t *cbor_head(uint8_t *out, uint8_t major, uint64_t value) {
+  major <<= 5;
+  if (value < 24) {
+    *out++ = major | (uint8_t) value;
+  } else if (value <= 0xFF) {
+    *out++ = major | 24;
+    *out++ = (uint8_t) value;
+  } else if (value <= 0xFFFF) {
+    *out++ = major | 25;
+    out = put_be(out, value, 2);
+  } else if (value <= 0xFFFFFFFF) {
+    *out++ = major | 26;
+    out = put_be(out, value, 4);
+  } else {
+    *out++ = major | 27;
+    out = put_be(out, value, 8);
+  }
+  return out;
+}
+
+static uint8_t *cbor_text(uint8_t *out, const char *text) {
+  const size_t len = std::strlen(text);
+  out = cbor_head(out, 3, len);
+  std::memcpy(out, text, len);
+  return out + len;
+}
+
+static uint8_t *cbor_int(uint8_t *out, int64_t value) {
+  return value < 0 ? cbor_head(out, 1, (uint64_t) (-1 - value)) : cbor_head(out, 0, (uint64_t) value);
+}
+
+Packet::Packet() {}
+
+void Packet::reset() {
+  this->size_ = 0;
+  this->expected_size_ = 0;
+  this->rssi_ = 0;
+  this->link_mode_ = LinkMode::UNKNOWN;
+  this->frame_format_ = "";
+  this->rx_time_ms_ = 0;
+  this->rx_time_is_wall_clock_ = false;
+  this->offset_ = 0;
+  this->is_raw_ = true;
+  this->converted_ = false;
+  this->want_len_ = 0;
+  this->got_len_ = 0;
+  this->raw_got_len_ = 0;
+  this->drop_reason_ = DropReason::NONE;
+}
 
 // Determine the link mode based on the first byte of the data
 LinkMode Packet::link_mode() {
-  if (this->link_mode_ == LinkMode::UNKNOWN)
-    if (this->data_.size())
-      if (this->data_[0] == WMBUS_MODE_C_PREAMBLE)
-        this->link_mode_ = LinkMode::C1;
-      else
-        this->link_mode_ = LinkMode::T1;
+  if (this->link_mode_ == LinkMode::UNKNOWN && this->size_ > 0)
+    this->link_mode_ = this->data_[0] == WMBUS_MODE_C_PREAMBLE ? LinkMode::C1 : LinkMode::T1;
 
   return this->link_mode_;
 }
 
 void Packet::set_rssi(int8_t rssi) { this->rssi_ = rssi; }
 
+void Packet::stamp_rx_time() {
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  // The clock counts from 1970 until SNTP sets it: anything before 2020
+  // is not a real date.
+  this->rx_time_is_wall_clock_ = tv.tv_sec > 1577836800;
+  if (this->rx_time_is_wall_clock_)
+    this->rx_time_ms_ = (uint64_t) tv.tv_sec * 1000 + tv.tv_usec / 1000;
+  else
+    this->rx_time_ms_ = (uint64_t) esp_timer_get_time() / 1000;
+}
+
 // Get value of L-field (best-effort; for RAW-only we avoid depending on this early)
 uint8_t Packet::l_field() {
   switch (this->link_mode()) {
     case LinkMode::C1:
-      if (this->data_.size() < 3) return 0;
+      if (this->size_ < 3) return 0;
       return this->data_[2];
 
     case LinkMode::T1: {
       // Decode a minimal prefix to obtain decoded[0] (L-field)
-      const size_t n = std::min<size_t>(this->data_.size(), 18);  // safer than 3
-      std::vector<uint8_t> tmp(this->data_.begin(), this->data_.begin() + n);
-      auto decoded = decode3of6(tmp);
-      if (decoded && !decoded->empty()) return (*decoded)[0];
+      uint8_t tmp[12];
+      const size_t n = std::min<size_t>(this->size_, 18);  // safer than 3
+      if (decode3of6(this->data_.data(), n, tmp)) return tmp[0];
       break;
     }
 
@@ -73,15 +159,15 @@ uint8_t Packet::l_field() {
 
 // Keep expected_size() for callers that may want it, but RAW-only path below does not require it.
 size_t Packet::expected_size() {
-  if (this->data_.size() < WMBUS_PREAMBLE_SIZE) return 0;
+  if (this->size_ < WMBUS_PREAMBLE_SIZE) return 0;
 
   if (!this->expected_size_) {
     auto l_field = this->l_field();
     if (l_field == 0) return 0;
 
-    // Number of blocks (format A/B framing rules)
-    auto nrBlocks = l_field < 26 ? 2 : (l_field - 26) / 16 + 3;
-    auto nrBytes = l_field + 1 + 2 * nrBlocks;
+    // T1 may be either format; format A (the longer one) is assumed here,
+    // see min_expected_size().
+    auto nrBytes = dll_size_format_a(l_field);
 
     if (this->link_mode() != LinkMode::C1) {
       this->expected_size_ = encoded_size(nrBytes);
@@ -96,155 +182,149 @@ size_t Packet::expected_size() {
   return this->expected_size_;
 }
 
-uint8_t *Packet::append_space(size_t len) {
-  const size_t old = this->data_.size();
-  this->data_.resize(old + len);
-  return this->data_.data() + old;
+size_t Packet::min_expected_size() {
+  if (this->link_mode() != LinkMode::T1) return this->expected_size();
+  if (this->size_ < WMBUS_PREAMBLE_SIZE) return 0;
+  auto l_field = this->l_field();
+  if (l_field == 0) return 0;
+  // Format B: L-field already counts the CRC bytes
+  return encoded_size(l_field + 1);
 }
 
-// Strip DLL CRC bytes from a decoded *Format A* frame in-place.
-// Input d must start with L-field at d[0] and still include DLL CRC bytes.
-// Output will be exactly (L+1) bytes if successful.
-static bool strip_dll_crc_format_a_inplace(std::vector<uint8_t> &d) {
-  if (d.empty()) return false;
-  const size_t want = static_cast<size_t>(d[0]) + 1;  // DLL without CRC bytes
-  if (want < 2) return false;
-  if (d.size() < want) return false;                  // must at least contain header+payload sans CRC
-
-  std::vector<uint8_t> out;
-  out.reserve(want);
-
-  size_t pos = 0;
-  int block = 0;
-
-  while (out.size() < want && pos < d.size()) {
-    const size_t data_len = (block == 0) ? 10 : 16;   // bytes per block excluding CRC
-    const size_t need = want - out.size();
-    const size_t take = std::min(data_len, need);
-
-    if (pos + take > d.size()) return false;
-    out.insert(out.end(), d.begin() + pos, d.begin() + pos + take);
-    pos += data_len;
-
-    // skip 2 CRC bytes after each block (if present)
-    if (pos + 2 <= d.size()) pos += 2;
-    block++;
-  }
+void Packet::shrink_to(size_t size) {
+  if (size < this->size_) this->size_ = size;
+}
 
-  if (out.size() != want) return false;
-  d = std::move(out);
-  return true;
+uint8_t *Packet::append_space(size_t len) {
+  if (len > PACKET_CAPACITY - this->size_) return nullptr;
+  const size_t old = this->size_;
+  this->size_ += len;
+  return this->data_.data() + old;
 }
 
 std::optional<Frame> Packet::convert_to_frame() {
   std::optional<Frame> frame = {};
+  if (this->converted_) {
+    if (this->drop_reason_ == DropReason::NONE)
+      frame.emplace(this);
+    return frame;
+  }
+  this->converted_ = true;
 
   // reset diagnostics
-  this->truncated_ = false;
   this->want_len_ = 0;
   this->got_len_ = 0;
-  this->raw_got_len_ = this->data_.size();
-  this->drop_reason_.clear();
-
-  // Capture raw bytes (hex) early for diagnostics. Keep it bounded.
-  // 256 bytes -> 512 hex chars, enough for typical dropped packets.
-  this->raw_hex_ = hex_prefix_(this->data_, 256);
+  this->raw_got_len_ = this->size_;
+  this->drop_reason_ = DropReason::NONE;
 
   // drop junk / partial frames (noise)
   const auto mode = this->link_mode();
-  if (mode == LinkMode::T1 && this->data_.size() < 60) {
-    this->drop_reason_ = "too_short";
+  if (mode == LinkMode::T1 && this->size_ < 60) {
+    this->drop_reason_ = DropReason::TOO_SHORT;
     return {};
   }
-  if (mode == LinkMode::C1 && this->data_.size() < 16) {
-    this->drop_reason_ = "too_short";
+  if (mode == LinkMode::C1 && this->size_ < 16) {
+    this->drop_reason_ = DropReason::TOO_SHORT;
     return {};
   }
 
+  uint8_t *data = this->data_.data();
+  DllCrcResult crc_result;
+
   // RAW-only: do not rely on expected_size gating (it can be wrong on partial prefixes).
   // We instead require successful decode/sanity and then trim based on decoded L-field.
+  // All checks that can fail run before the buffer is modified, so rejected
+  // packets keep their raw bytes for diagnostics.
   if (mode == LinkMode::T1) {
-    this->frame_format_ = "A";  // assumption (good enough for water meters you're seeing)
-    auto decoded_data = decode3of6(this->data_);
-    if (!decoded_data || decoded_data->size() < 2) {
-      this->drop_reason_ = "decode_failed";
+    uint8_t head[12];
+    if (decode3of6(data, encoded_size(sizeof(head)), head) != sizeof(head)) {
+      this->drop_reason_ = DropReason::DECODE_FAILED;
       return {};
     }
-    this->data_ = decoded_data.value();
 
     // Sanity based on L-field
-    const size_t want = static_cast<size_t>(this->data_[0]) + 1;
-    this->want_len_ = want;
-    this->got_len_ = this->data_.size();
-    if (want < 12 || want > 260) {
-      this->drop_reason_ = "l_field_invalid";
-      return {};
-    }
-    if (this->data_.size() < want) {
-      this->truncated_ = true;
-      this->drop_reason_ = "truncated";
+    const size_t l_want = static_cast<size_t>(head[0]) + 1;
+    const size_t decodable = this->size_ * 2 / 3;
+    if (l_want < 12 || l_want > 260) {
+      this->want_len_ = l_want;
+      this->got_len_ = decodable;
+      this->drop_reason_ = DropReason::L_FIELD_INVALID;
       return {};
     }
 
-    // Keep only what we need (drop any trailing garbage)
-    if (this->data_.size() > want + 64) {  // hard safety
-      this->data_.resize(want + 64);
+    this->frame_format_ = t1_is_format_a(data, this->size_, head) ? "A" : "B";
+    const size_t want = this->frame_format_[0] == 'A' ? dll_size_format_a(head[0]) : l_want;
+    this->want_len_ = want;
+    this->got_len_ = std::min(want, decodable);
+    const size_t coded_len = encoded_size(want);
+    if (coded_len > this->size_) {
+      this->drop_reason_ = DropReason::TRUNCATED;
+      return {};
     }
 
-    // For format A, remove DLL CRC bytes so wmbusmeters hex input doesn't choke (F8/FE CI)
-    if (!strip_dll_crc_format_a_inplace(this->data_)) {
-      // If we had enough bytes per L-field but stripping failed, treat as malformed.
-      this->drop_reason_ = "dll_crc_strip_failed";
+    // Decode just as much as the frame needs so trailing noise is ignored.
+    // Validate first, then decode in place (which can no longer fail).
+    if (decode3of6(data, coded_len, nullptr) != want) {
+      this->drop_reason_ = DropReason::DECODE_FAILED;
       return {};
     }
+    decode3of6(data, coded_len, data);
+    this->size_ = want;
+    this->is_raw_ = false;
+
+    // Remove DLL CRC bytes so wmbusmeters hex input doesn't choke (F8/FE CI)
+    crc_result = this->frame_format_[0] == 'A' ? strip_dll_crc_format_a(data, this->size_)
+                                               : strip_dll_crc_format_b(data, this->size_);
 
   } else if (mode == LinkMode::C1) {
-    if (this->data_.size() < 3) {
-      this->drop_reason_ = "too_short";
+    if (this->size_ < 3) {
+      this->drop_reason_ = DropReason::TOO_SHORT;
       return {};
     }
-    if (this->data_[1] == WMBUS_BLOCK_A_PREAMBLE) {
+    if (data[1] == WMBUS_BLOCK_A_PREAMBLE) {
       this->frame_format_ = "A";
-    } else if (this->data_[1] == WMBUS_BLOCK_B_PREAMBLE) {
+    } else if (data[1] == WMBUS_BLOCK_B_PREAMBLE) {
       this->frame_format_ = "B";
     } else {
-      this->drop_reason_ = "unknown_preamble";
+      this->drop_reason_ = DropReason::UNKNOWN_PREAMBLE;
       return {};
     }
 
-    // remove C-mode suffix bytes
-    if (this->data_.size() < WMBUS_MODE_C_SUFIX_LEN) {
-      this->drop_reason_ = "too_short";
-      return {};
-    }
-    this->data_.erase(this->data_.begin(), this->data_.begin() + WMBUS_MODE_C_SUFIX_LEN);
+    // skip C-mode suffix bytes; the frame starts right after them
+    data += WMBUS_MODE_C_SUFIX_LEN;
+    size_t len = this->size_ - WMBUS_MODE_C_SUFIX_LEN;
 
     // Sanity based on L-field now at [0]
-    const size_t want = static_cast<size_t>(this->data_[0]) + 1;
+    const size_t l_want = static_cast<size_t>(data[0]) + 1;
+    const size_t want = this->frame_format_[0] == 'A' ? dll_size_format_a(data[0]) : l_want;
     this->want_len_ = want;
-    this->got_len_ = this->data_.size();
-    if (want < 12 || want > 260) {
-      this->drop_reason_ = "l_field_invalid";
+    this->got_len_ = len;
+    if (l_want < 12 || l_want > 260) {
+      this->drop_reason_ = DropReason::L_FIELD_INVALID;
       return {};
     }
-    if (this->data_.size() < want) {
-      this->truncated_ = true;
-      this->drop_reason_ = "truncated";
+    if (len < want) {
+      this->drop_reason_ = DropReason::TRUNCATED;
       return {};
     }
-    if (this->data_.size() > want) this->data_.resize(want);
-
-    // Only strip DLL CRC for format A; format B here is already shorter and typically without intermediate CRC bytes
-    if (this->frame_format_ == "A") {
-      // C1(A) still has DLL CRC bytes in the decoded stream -> strip them
-      if (!strip_dll_crc_format_a_inplace(this->data_)) {
-        this->drop_reason_ = "dll_crc_strip_failed";
-        return {};
-      }
+
+    // Drop trailing bytes, then verify and remove DLL CRCs (the buffer is
+    // only modified once every CRC matched)
+    len = want;
+    crc_result = this->frame_format_[0] == 'A' ? strip_dll_crc_format_a(data, len)
+                                               : strip_dll_crc_format_b(data, len);
+    if (crc_result == DllCrcResult::OK) {
+      this->offset_ = WMBUS_MODE_C_SUFIX_LEN;
+      this->size_ = this->offset_ + len;
     }
 
   } else {
-    this->drop_reason_ = "unknown_link_mode";
+    this->drop_reason_ = DropReason::UNKNOWN_LINK_MODE;
+    return {};
+  }
+
+  if (crc_result != DllCrcResult::OK) {
+    this->drop_reason_ = DropReason::DLL_CRC_STRIP_FAILED;
     return {};
   }
 
@@ -254,36 +334,122 @@ std::optional<Frame> Packet::convert_to_frame() {
 }
 
 Frame::Frame(Packet *packet)
-    : data_(std::move(packet->data_)), link_mode_(packet->link_mode_),
-      rssi_(packet->rssi_), format_(packet->frame_format_) {}
+    : data_(packet->data_.data() + packet->offset_), size_(packet->size_ - packet->offset_),
+      link_mode_(packet->link_mode_),
+      rssi_(packet->rssi_), format_(packet->frame_format_), timestamp_ms_(packet->rx_time_ms_),
+      wall_clock_(packet->rx_time_is_wall_clock_) {
+  // Frames are at least 12 bytes (checked in convert_to_frame())
+  this->header_.parse(this->data_, this->size_);
+}
 
-std::vector<uint8_t> &Frame::data() { return this->data_; }
 LinkMode Frame::link_mode() { return this->link_mode_; }
 int8_t Frame::rssi() { return this->rssi_; }
-std::string Frame::format() { return this->format_; }
+std::string_view Frame::format() { return this->format_; }
+
+std::vector<uint8_t> Frame::as_raw() { return std::vector<uint8_t>(this->data_, this->data_ + this->size_); }
 
-std::vector<uint8_t> Frame::as_raw() { return this->data_; }
-std::string Frame::as_hex() { return format_hex(this->data_); }
+std::string Frame::as_hex() {
+  std::string output(2 * this->size_, '\0');
+  write_hex_chars(this->data_, this->size_, &output[0]);
+  return output;
+}
 
 std::string Frame::as_rtlwmbus() {
+  std::string output(this->rtlwmbus_buffer_size(), '\0');
+  output.resize(this->write_rtlwmbus(&output[0], output.size()));
+  return output;
+}
+
+std::vector<uint8_t> Frame::as_binary() {
+  std::vector<uint8_t> output(this->binary_buffer_size());
+  output.resize(this->write_binary(output.data(), output.size()));
+  return output;
+}
+
+std::vector<uint8_t> Frame::as_cbor() {
+  std::vector<uint8_t> output(this->cbor_buffer_size());
+  output.resize(this->write_cbor(output.data(), output.size()));
+  return output;
+}
+
+size_t Frame::write_raw(uint8_t *out, size_t out_len) const {
+  if (out_len < this->size_) return 0;
+  std::memcpy(out, this->data_, this->size_);
+  return this->size_;
+}
+
+size_t Frame::write_hex(char *out, size_t out_len) const {
+  if (out_len < this->hex_buffer_size()) return 0;
+  write_hex_chars(this->data_, this->size_, out);
+  out[2 * this->size_] = '\0';
+  return 2 * this->size_;
+}
+
+size_t Frame::write_rtlwmbus(char *out, size_t out_len) const {
+  if (out_len < this->rtlwmbus_buffer_size()) return 0;
+
   const size_t time_repr_size = sizeof("YYYY-MM-DD HH:MM:SS.00Z");
   char time_buffer[time_repr_size];
-  auto t = std::time(NULL);
+  auto t = this->wall_clock_ ? (time_t) (this->timestamp_ms_ / 1000) : std::time(NULL);
   std::strftime(time_buffer, time_repr_size, "%F %T.00Z", std::gmtime(&t));
 
-  auto output = std::string{};
-  output.reserve(2 + 5 + 24 + 1 + 4 + 5 + 2 * this->data_.size() + 1);
+  int n = snprintf(out, out_len, "%s;1;1;%s;%d;;;0x", link_mode_name(this->link_mode_), time_buffer,
+                   (int) this->rssi_);
+  if (n < 0) return 0;
+  write_hex_chars(this->data_, this->size_, out + n);
+  n += 2 * this->size_;
+  out[n++] = '\n';
+  out[n] = '\0';
+  return n;
+}
+
+size_t Frame::write_binary(uint8_t *out, size_t out_len) const {
+  if (out_len < this->binary_buffer_size() || this->size_ > 0xFFFF) return 0;
+  uint8_t *p = out;
+  *p++ = BINARY_VERSION;
+  *p++ = BINARY_HEADER_SIZE;
+  *p++ = (uint8_t) this->link_mode_;
+  *p++ = (uint8_t) this->format_[0];
+  *p++ = (uint8_t) this->rssi_;
+  *p++ = this->wall_clock_ ? BINARY_FLAG_WALL_CLOCK : 0;
+  p = put_be(p, this->size_, 2);
+  p = put_be(p, this->sequence_, 4);
+  p = put_be(p, this->timestamp_ms_, 8);
+  std::memcpy(p, this->data_, this->size_);
+  return BINARY_HEADER_SIZE + this->size_;
+}
 
-  output += link_mode_name(this->link_mode_);
-  output += ";1;1;";
-  output += time_buffer;
-  output += ';';
-  output += std::to_string(this->rssi_);
-  output += ";;;0x";
-  output += this->as_hex();
-  output += "\n";
+size_t Frame::write_cbor(uint8_t *out, size_t out_len) const {
+  if (out_len < this->cbor_buffer_size() || this->size_ > 0xFFFF) return 0;
+  uint8_t *p = cbor_head(out, 5, 8);
+  p = cbor_text(p, "v");
+  p = cbor_head(p, 0, BINARY_VERSION);
+  p = cbor_text(p, "seq");
+  p = cbor_head(p, 0, this->sequence_);
+  p = cbor_text(p, "ts");
+  p = cbor_head(p, 0, this->timestamp_ms_);
+  p = cbor_text(p, "wall");
+  *p++ = this->wall_clock_ ? 0xF5 : 0xF4;
+  p = cbor_text(p, "rssi");
+  p = cbor_int(p, this->rssi_);
+  p = cbor_text(p, "mode");
+  p = cbor_text(p, link_mode_name(this->link_mode_));
+  p = cbor_text(p, "fmt");
+  p = cbor_text(p, this->format_);
+  p = cbor_text(p, "data");
+  p = cbor_head(p, 2, this->size_);
+  std::memcpy(p, this->data_, this->size_);
+  return (p - out) + this->size_;
+}
 
-  return output;
+const std::string &Frame::hex() {
+  std::string &text = this->text_cache_ != nullptr ? *this->text_cache_ : this->own_text_;
+  if (!this->hex_ready_) {
+    text.resize(2 * this->size_);
+    write_hex_chars(this->data_, this->size_, &text[0]);
+    this->hex_ready_ = true;
+  }
+  return text;
 }
 
 void Frame::mark_as_handled() { this->handlers_count_++; }
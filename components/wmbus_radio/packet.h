@@ -1,37 +1,99 @@
 #pragma once
+#include <array>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <ctime>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 // Keep wmbus_radio lightweight: do NOT pull full wmbusmeters/wmbus_common.
 // We only need LinkMode names and basic helpers.
+#include "frame_header.h"
 #include "link_mode.h"
 #include "esphome/core/helpers.h"
 
 namespace esphome {
 namespace wmbus_radio {
 
+// Fixed capacity of the packet buffer. The longest on-air packet we accept
+// (T1, L-field 0xFF, format A) is 435 bytes 3-of-6 encoded.
+static constexpr size_t PACKET_CAPACITY = 512;
+
+// Why convert_to_frame() rejected a packet. Values index diagnostic counters.
+enum class DropReason : uint8_t {
+  NONE = 0,
+  TOO_SHORT,
+  DECODE_FAILED,
+  DLL_CRC_STRIP_FAILED,
+  UNKNOWN_PREAMBLE,
+  L_FIELD_INVALID,
+  UNKNOWN_LINK_MODE,
+  TRUNCATED,
+  QUEUE_FULL,  // never set by Packet: counted by the receiver task
+  COUNT
+};
+
+inline const char *drop_reason_name(DropReason reason) {
+  switch (reason) {
+    case DropReason::NONE:
+      return "none";
+    case DropReason::TOO_SHORT:
+      return "too_short";
+    case DropReason::DECODE_FAILED:
+      return "decode_failed";
+    case DropReason::DLL_CRC_STRIP_FAILED:
+      return "dll_crc_strip_failed";
+    case DropReason::UNKNOWN_PREAMBLE:
+      return "unknown_preamble";
+    case DropReason::L_FIELD_INVALID:
+      return "l_field_invalid";
+    case DropReason::UNKNOWN_LINK_MODE:
+      return "unknown_link_mode";
+    case DropReason::TRUNCATED:
+      return "truncated";
+    case DropReason::QUEUE_FULL:
+      return "queue_full";
+    default:
+      return "other";
+  }
+}
+
 struct Frame;
 
 struct Packet {
-  friend class Frame;
+  friend struct Frame;
+  friend class PacketPool;
 
 public:
   Packet();
 
-  // Reserve/extend internal buffer and return pointer to the newly appended
-  // region. The returned memory is valid until the next reallocation.
+  // Return to the freshly constructed state so the packet can be reused.
+  void reset();
+
+  // Extend internal buffer and return pointer to the newly appended region.
+  // Returns nullptr if the packet would exceed PACKET_CAPACITY.
   uint8_t *append_space(size_t len);
 
   // Expected total packet size (including PHY header bytes as provided by
   // the transceiver). Returns 0 if it can't be determined from current data.
   size_t expected_size();
+  // Smallest total size the packet can have: differs from expected_size()
+  // for T1, where format B frames are shorter than format A ones.
+  size_t min_expected_size();
+
+  // Drop bytes past `size` (e.g. an optional tail the radio did not deliver).
+  void shrink_to(size_t size);
 
   void set_rssi(int8_t rssi);
+  // Record the reception time: wall clock once SNTP has set it, uptime before
+  void stamp_rx_time();
 
+  // Decode, check and strip the DLL CRCs in place. Only the first call does
+  // the work: later calls (e.g. loop() after the processing task) return the
+  // same result without touching the buffer again.
   std::optional<Frame> convert_to_frame();
 
   // Basic getters for diagnostics
@@ -39,18 +101,31 @@ public:
   int8_t get_rssi() const { return this->rssi_; }
 
   // Diagnostics (populated when convert_to_frame() rejects a packet)
-  bool is_truncated() const { return this->truncated_; }
+  bool is_truncated() const { return this->drop_reason_ == DropReason::TRUNCATED; }
   size_t want_len() const { return this->want_len_; }
   size_t got_len() const { return this->got_len_; }
   size_t raw_got_len() const { return this->raw_got_len_; }
-  const std::string &drop_reason() const { return this->drop_reason_; }
+  DropReason drop_reason() const { return this->drop_reason_; }
+  // esp_timer time at which the receiver task queued the packet
+  int64_t queued_at_us() const { return this->queued_at_us_; }
 
-  // Raw packet bytes (hex) captured at the beginning of convert_to_frame().
-  // Intended for diagnostics; may be truncated to keep MQTT/log payloads small.
-  const std::string &raw_hex() const { return this->raw_hex_; }
+  // Bytes currently held by the packet. Nothing is copied for diagnostics:
+  // a rejected packet still holds exactly what the transceiver delivered
+  // (is_raw()), except for T1 frames rejected after in-place decoding, which
+  // hold the decoded bytes instead.
+  const uint8_t *data() const { return this->data_.data(); }
+  size_t size() const { return this->size_; }
+  bool is_raw() const { return this->is_raw_; }
 
 protected:
-  std::vector<uint8_t> data_;
+  // Raw bytes as read from the transceiver. Decoding and DLL CRC removal are
+  // done in place, so after convert_to_frame() this holds the frame itself.
+  std::array<uint8_t, PACKET_CAPACITY> data_;
+  size_t size_{0};
+  // Start of the frame within data_ (C-mode prefix is skipped, not moved)
+  size_t offset_{0};
+  bool is_raw_{true};
+  bool converted_{false};
 
   size_t expected_size_ = 0;
 
@@ -60,39 +135,122 @@ protected:
   LinkMode link_mode();
   LinkMode link_mode_ = LinkMode::UNKNOWN;
 
-  std::string frame_format_;
+  const char *frame_format_{""};
+
+  uint64_t rx_time_ms_{0};
+  bool rx_time_is_wall_clock_{false};
 
   // Diagnostics
-  bool truncated_{false};
   size_t want_len_{0};
   size_t got_len_{0};
   size_t raw_got_len_{0};
-  std::string drop_reason_{};
-  std::string raw_hex_{};
+  DropReason drop_reason_{DropReason::NONE};
+
+  // Queue bookkeeping, owned by PacketPool
+  std::atomic<uint8_t> queue_state_{0};
+  int64_t queued_at_us_{0};
 };
 
+// Non-owning view of a decoded frame. It points into the Packet buffer it was
+// created from and is only valid as long as that Packet is alive.
 struct Frame {
 public:
+  // Payload formats for the built-in telegram publisher
+  enum OutputFormat : uint8_t {
+    FORMAT_HEX,
+    FORMAT_RTLWMBUS,
+    FORMAT_BINARY,
+    FORMAT_CBOR,
+    FORMAT_DELTA,  // see DeltaEncoder
+  };
+
+  // Binary envelope, version 1 (multi-byte fields big-endian):
+  //   0  u8   version (1)
+  //   1  u8   header length (20); payload starts here
+  //   2  u8   link mode (0 unknown, 1 T1, 2 C1)
+  //   3  u8   frame format ('A', 'B' or 0)
+  //   4  i8   RSSI [dBm]
+  //   5  u8   flags, bit 0: timestamp is Unix time (otherwise uptime)
+  //   6  u16  payload length
+  //   8  u32  bridge sequence number
+  //   12 u64  reception timestamp [ms]
+  //   20 ...  frame bytes, DLL CRCs removed (same as as_raw())
+  static constexpr uint8_t BINARY_VERSION = 1;
+  static constexpr size_t BINARY_HEADER_SIZE = 20;
+  static constexpr uint8_t BINARY_FLAG_WALL_CLOCK = 0x01;
+
   Frame(Packet *packet);
 
-  std::vector<uint8_t> &data();
+  const uint8_t *data() const { return this->data_; }
+  size_t size() const { return this->size_; }
   LinkMode link_mode();
   int8_t rssi();
-  std::string format();
+  // "A", "B" or empty; compares with string literals like the std::string it once was
+  std::string_view format();
+
+  // Link layer header (C, M, ID, version, type, CI), parsed once per frame
+  const FrameHeader &header() const { return this->header_; }
+
+  // Reception time in ms: Unix time if timestamp_is_wall_clock(), else uptime
+  uint64_t timestamp_ms() const { return this->timestamp_ms_; }
+  bool timestamp_is_wall_clock() const { return this->wall_clock_; }
+  // Bridge sequence number, assigned by the radio to every accepted frame
+  uint32_t sequence() const { return this->sequence_; }
+  void set_sequence(uint32_t sequence) { this->sequence_ = sequence; }
 
   std::vector<uint8_t> as_raw();
   std::string as_hex();
   std::string as_rtlwmbus();
+  std::vector<uint8_t> as_binary();
+  std::vector<uint8_t> as_cbor();
+
+  // Allocation-free serializers. They write into `out` (text is
+  // NUL-terminated) and return the length without the terminator, or 0 if
+  // `out_len` is too small, in which case nothing is written.
+  size_t write_raw(uint8_t *out, size_t out_len) const;
+  size_t write_hex(char *out, size_t out_len) const;
+  size_t write_rtlwmbus(char *out, size_t out_len) const;
+  // Binary envelope (see above) and the same fields as a CBOR map:
+  // {"v", "seq", "ts", "wall", "rssi", "mode", "fmt", "data" (byte string)}
+  size_t write_binary(uint8_t *out, size_t out_len) const;
+  size_t write_cbor(uint8_t *out, size_t out_len) const;
+  // Buffer sizes (including the terminator) needed by the writers above
+  size_t hex_buffer_size() const { return 2 * this->size_ + 1; }
+  size_t rtlwmbus_buffer_size() const { return RTLWMBUS_OVERHEAD + 2 * this->size_; }
+  size_t binary_buffer_size() const { return BINARY_HEADER_SIZE + this->size_; }
+  size_t cbor_buffer_size() const { return CBOR_OVERHEAD + this->size_; }
+
+  // Hex of the frame, rendered at most once per frame. Automations can call
+  // it repeatedly (size check + payload) at no extra cost. Rendered into the
+  // buffer passed to set_text_cache() if any, which the radio reuses for
+  // every frame so this does not allocate once the buffer has grown.
+  const std::string &hex();
+  void set_text_cache(std::string *cache) { this->text_cache_ = cache; }
 
   void mark_as_handled();
   uint8_t handlers_count();
 
 protected:
-  std::vector<uint8_t> data_;
+  // "C1;1;1;" + "YYYY-MM-DD HH:MM:SS.00Z" + ";-128;;;0x" + "\n" + NUL
+  static constexpr size_t RTLWMBUS_OVERHEAD = 7 + 23 + 10 + 2;
+  // Map header + keys + values at their widest encoding + byte string header
+  static constexpr size_t CBOR_OVERHEAD = 1 + (2 + 1) + (4 + 5) + (3 + 9) + (5 + 1) + (5 + 2) +
+                                          (5 + 3) + (4 + 2) + (5 + 3);
+
+  const uint8_t *data_;
+  size_t size_;
   LinkMode link_mode_;
   int8_t rssi_;
-  std::string format_;
+  const char *format_;
+  uint64_t timestamp_ms_;
+  bool wall_clock_;
+  uint32_t sequence_{0};
+  FrameHeader header_;
   uint8_t handlers_count_ = 0;
+
+  std::string *text_cache_{nullptr};
+  std::string own_text_;
+  bool hex_ready_{false};
 };
 
 } // namespace wmbus_radio
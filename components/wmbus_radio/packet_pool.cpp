@@ -0,0 +1,150 @@
+#include "packet_pool.h"
+
+#include <new>
+
+#include "esp_timer.h"
+
+#include "esphome/core/helpers.h"
+#include "esphome/core/log.h"
+
+namespace esphome {
+namespace wmbus_radio {
+static const char *const TAG = "wmbus_radio.pool";
+
+bool PacketPool::init(size_t depth, bool prefer_psram, OverflowPolicy policy) {
+  if (depth == 0 || this->packets_ != nullptr)
+    return false;
+
+  const size_t count = policy == OVERFLOW_DROP_NEWEST ? depth : depth + 1;
+  RAMAllocator<Packet> allocator(prefer_psram ? RAMAllocator<Packet>::NONE
+                                              : RAMAllocator<Packet>::ALLOC_INTERNAL);
+  this->packets_ = allocator.allocate(count);
+  if (this->packets_ == nullptr) {
+    ESP_LOGE(TAG, "Cannot allocate %zu packets (%zu bytes)", count, count * sizeof(Packet));
+    return false;
+  }
+
+  this->count_ = count;
+  this->depth_ = depth;
+  this->policy_ = policy;
+  this->free_.init(count);
+  this->ready_.init(count);
+  this->processed_.init(count);
+  for (size_t i = 0; i < count; i++) {
+    // Not waiting anywhere, so never a candidate for eviction
+    new (&this->packets_[i]) Packet();
+    this->packets_[i].queue_state_.store(STATE_CLAIMED, std::memory_order_relaxed);
+  }
+  for (size_t i = 0; i < depth; i++)
+    this->free_.push(&this->packets_[i]);
+  if (count > depth)
+    this->spare_ = &this->packets_[depth];
+
+  ESP_LOGD(TAG, "Allocated %zu packets (%zu bytes)", count, count * sizeof(Packet));
+  return true;
+}
+
+bool PacketPool::transition_(Packet *packet, QueueState to) {
+  uint8_t expected = STATE_QUEUED;
+  return packet->queue_state_.compare_exchange_strong(expected, to, std::memory_order_acq_rel);
+}
+
+Packet *PacketPool::acquire() {
+  Packet *packet;
+  // A spare that went out with an overflow is replaced by the next free packet
+  if (this->policy_ != OVERFLOW_DROP_NEWEST && this->spare_ == nullptr && this->free_.pop(packet))
+    this->spare_ = packet;
+  if (!this->free_.pop(packet))
+    return nullptr;
+  return packet;
+}
+
+Packet *PacketPool::take_spare() {
+  Packet *packet = this->spare_;
+  this->spare_ = nullptr;
+  return packet;
+}
+
+void PacketPool::restore_spare(Packet *packet) { this->spare_ = packet; }
+
+bool PacketPool::submit(Packet *packet) {
+  packet->queued_at_us_ = esp_timer_get_time();
+  packet->queue_state_.store(STATE_QUEUED, std::memory_order_relaxed);
+  return this->ready_.push(packet);
+}
+
+bool PacketPool::evict_for(const Packet *incoming) {
+  if (this->policy_ == OVERFLOW_DROP_NEWEST)
+    return false;
+
+  // Every waiting packet is a candidate, whichever ring it is in. Only the
+  // receiver task writes queued_at_us_ and rssi_, so reading them is safe.
+  while (true) {
+    Packet *victim = nullptr;
+    for (size_t i = 0; i < this->count_; i++) {
+      Packet *packet = &this->packets_[i];
+      if (packet == incoming || packet->queue_state_.load(std::memory_order_acquire) != STATE_QUEUED)
+        continue;
+      if (victim == nullptr ||
+          (this->policy_ == OVERFLOW_DROP_OLDEST ? packet->queued_at_us_ < victim->queued_at_us_
+                                                 : packet->rssi_ < victim->rssi_))
+        victim = packet;
+    }
+    if (victim == nullptr)
+      return false;
+    if (this->policy_ == OVERFLOW_DROP_LOWEST_RSSI && victim->rssi_ >= incoming->rssi_)
+      return false;
+    // Fails only if a consumer claimed it meanwhile: look again
+    if (transition_(victim, STATE_EVICTED))
+      return true;
+  }
+}
+
+size_t PacketPool::waiting() const {
+  size_t waiting = 0;
+  for (size_t i = 0; i < this->count_; i++)
+    waiting += this->packets_[i].queue_state_.load(std::memory_order_relaxed) == STATE_QUEUED;
+  return waiting;
+}
+
+Packet *PacketPool::receive() {
+  Packet *packet;
+  while (this->ready_.pop(packet)) {
+    if (transition_(packet, STATE_CLAIMED))
+      return packet;
+    this->release(packet);
+  }
+  return nullptr;
+}
+
+Packet *PacketPool::receive_for_processing() {
+  Packet *packet;
+  while (this->ready_.pop(packet)) {
+    if (transition_(packet, STATE_CLAIMED))
+      return packet;
+    this->forward(packet);
+  }
+  return nullptr;
+}
+
+void PacketPool::forward(Packet *packet) {
+  // Evicted packets stay evicted, for the main loop to release
+  uint8_t expected = STATE_CLAIMED;
+  packet->queue_state_.compare_exchange_strong(expected, STATE_QUEUED, std::memory_order_acq_rel);
+  this->processed_.push(packet);
+}
+
+Packet *PacketPool::receive_processed() {
+  Packet *packet;
+  while (this->processed_.pop(packet)) {
+    if (transition_(packet, STATE_CLAIMED))
+      return packet;
+    this->release(packet);
+  }
+  return nullptr;
+}
+
+void PacketPool::release(Packet *packet) { this->free_.push(packet); }
+
+} // namespace wmbus_radio
+} // namespace esphome
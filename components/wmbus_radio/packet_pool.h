@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+
+#include "packet.h"
+#include "spsc_ring.h"
+
+namespace esphome {
+namespace wmbus_radio {
+
+// Fixed set of packets preallocated at setup and handed between the receiver
+// task and the main loop through single-producer/single-consumer rings:
+//  - free:      main loop -> receiver task (packets ready to be filled)
+//  - ready:     receiver task -> main loop or processing task
+//  - processed: processing task -> main loop (already decoded packets)
+// No packet is ever allocated or freed after init().
+class PacketPool {
+public:
+  // What the receiver task does with a new packet when every packet is in use
+  enum OverflowPolicy : uint8_t {
+    OVERFLOW_DROP_NEWEST,  // don't read it
+    OVERFLOW_DROP_OLDEST,  // replace the packet waiting longest
+    OVERFLOW_DROP_LOWEST_RSSI,  // replace the weakest packet (or drop the new one if it is weaker)
+  };
+
+  // Allocate `depth` packets, in PSRAM when `prefer_psram` is set and PSRAM
+  // is available (falls back to internal RAM otherwise). Policies other than
+  // drop newest need one more packet, reserved for reading during overflow.
+  bool init(size_t depth, bool prefer_psram, OverflowPolicy policy = OVERFLOW_DROP_NEWEST);
+  size_t depth() const { return this->depth_; }
+  OverflowPolicy policy() const { return this->policy_; }
+
+  // Receiver task side
+  Packet *acquire();
+  // Packet reserved for overflow (nullptr with drop newest or while in use)
+  Packet *take_spare();
+  void restore_spare(Packet *packet);
+  bool submit(Packet *packet);
+  // Drop one waiting packet in favour of `incoming` (the spare) according to
+  // the policy: queued, or decoded by the processing task and not yet
+  // handled. False if `incoming` should be dropped instead.
+  bool evict_for(const Packet *incoming);
+  // Packets waiting for the processing task or the main loop, not counting
+  // evicted ones that are still on their way back
+  size_t waiting() const;
+
+  // Main loop side, without a processing task. Packets evicted in the
+  // meantime are released on the way.
+  Packet *receive();
+  void release(Packet *packet);
+  size_t queued() const { return this->ready_.size(); }
+
+  // Processing task side: like receive(), but evicted packets are forwarded
+  // for the main loop to release
+  Packet *receive_for_processing();
+  // Processing task -> main loop. Never fails: the ring holds every packet.
+  // A decoded packet can be evicted again until the main loop takes it.
+  void forward(Packet *packet);
+  Packet *receive_processed();
+  size_t processed_queued() const { return this->processed_.size(); }
+
+protected:
+  enum QueueState : uint8_t {
+    STATE_QUEUED,
+    STATE_CLAIMED,
+    STATE_EVICTED,
+  };
+  static bool transition_(Packet *packet, QueueState to);
+
+  Packet *packets_{nullptr};
+  // depth_, plus the spare if the policy needs one
+  size_t count_{0};
+  size_t depth_{0};
+  OverflowPolicy policy_{OVERFLOW_DROP_NEWEST};
+  // Owned by the receiver task
+  Packet *spare_{nullptr};
+  SpscRing<Packet *> free_;
+  SpscRing<Packet *> ready_;
+  SpscRing<Packet *> processed_;
+};
+
+} // namespace wmbus_radio
+} // namespace esphome
@@ -0,0 +1,72 @@
+#include "publish_policy.h"
+
+#include <algorithm>
+
+#include "dedup_cache.h"
+
+namespace esphome {
+namespace wmbus_radio {
+
+static bool policy_less(const PublishPolicies::Policy &policy, uint64_t key) {
+  return meter_key(policy.manufacturer, policy.id) < key;
+}
+
+void PublishPolicies::add(uint16_t manufacturer, uint32_t id, uint32_t min_interval_ms, bool on_change_only,
+                          uint32_t heartbeat_ms) {
+  const uint64_t key = meter_key(manufacturer, id);
+  auto it = std::lower_bound(this->policies_.begin(), this->policies_.end(), key, policy_less);
+  if (it == this->policies_.end() || meter_key(it->manufacturer, it->id) != key)
+    it = this->policies_.insert(it, Policy{manufacturer, id});
+  it->min_interval_ms = min_interval_ms;
+  it->on_change_only = on_change_only;
+  it->heartbeat_ms = heartbeat_ms;
+}
+
+PublishPolicies::Policy *PublishPolicies::find_(uint16_t manufacturer, uint32_t id) {
+  // A policy for this manufacturer wins over one for the ID alone
+  for (const uint64_t key : {meter_key(manufacturer, id), meter_key(0, id)}) {
+    auto it = std::lower_bound(this->policies_.begin(), this->policies_.end(), key, policy_less);
+    if (it != this->policies_.end() && meter_key(it->manufacturer, it->id) == key)
+      return &*it;
+  }
+  return nullptr;
+}
+
+bool PublishPolicies::should_publish(const FrameHeader &header, const uint8_t *frame, size_t len, uint32_t now_ms) {
+  if (this->policies_.empty())
+    return true;
+  Policy *policy = this->find_(header.manufacturer, header.id);
+  if (policy == nullptr)
+    return true;
+
+  uint32_t hash = 0;
+  if (policy->on_change_only) {
+    // The access number changes with every telegram: leave it out
+    const size_t offset = parse_tpl_header(frame, len).payload_offset;
+    hash = DedupCache::hash(frame + offset, len - offset);
+  }
+
+  bool publish = true;
+  if (policy->published) {
+    const uint32_t since = now_ms - policy->last_publish_ms;
+    if (policy->heartbeat_ms == 0 || since < policy->heartbeat_ms)
+      publish = since >= policy->min_interval_ms && (!policy->on_change_only || hash != policy->last_payload_hash);
+  }
+
+  if (!publish) {
+    policy->suppressed++;
+    return false;
+  }
+  policy->published = true;
+  policy->last_publish_ms = now_ms;
+  policy->last_payload_hash = hash;
+  return true;
+}
+
+void PublishPolicies::reset_stats() {
+  for (auto &policy : this->policies_)
+    policy.suppressed = 0;
+}
+
+} // namespace wmbus_radio
+} // namespace esphome
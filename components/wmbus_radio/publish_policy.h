@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "frame_header.h"
+
+namespace esphome {
+namespace wmbus_radio {
+
+// Per-meter rate limits for meters that transmit far more often than the
+// values are needed. Meters without a policy are always published.
+class PublishPolicies {
+public:
+  struct Policy {
+    uint16_t manufacturer;  // 0: any manufacturer
+    uint32_t id;
+    // Publish at most this often
+    uint32_t min_interval_ms{0};
+    // Publish only when the application data changed since the last
+    // published telegram (compared past ACC, status and configuration)
+    bool on_change_only{false};
+    // ...but at least this often (0: never forced)
+    uint32_t heartbeat_ms{0};
+
+    // State
+    bool published{false};
+    uint32_t last_publish_ms{0};
+    uint32_t last_payload_hash{0};
+    uint32_t suppressed{0};
+  };
+
+  void add(uint16_t manufacturer, uint32_t id, uint32_t min_interval_ms, bool on_change_only,
+           uint32_t heartbeat_ms);
+  bool is_enabled() const { return !this->policies_.empty(); }
+
+  // Decides for a decoded frame; false means the frame should be dropped
+  bool should_publish(const FrameHeader &header, const uint8_t *frame, size_t len, uint32_t now_ms);
+
+  const std::vector<Policy> &policies() const { return this->policies_; }
+  void reset_stats();
+
+protected:
+  Policy *find_(uint16_t manufacturer, uint32_t id);
+
+  // Sorted by key for binary search
+  std::vector<Policy> policies_;
+};
+
+} // namespace wmbus_radio
+} // namespace esphome
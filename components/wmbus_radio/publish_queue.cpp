@@ -0,0 +1,118 @@
+#include "publish_queue.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "esp_timer.h"
+
+#include "esphome/core/log.h"
+
+#include "esphome/components/mqtt/mqtt_client.h"
+
+namespace esphome {
+namespace wmbus_radio {
+static const char *const TAG = "wmbus_radio.publish_queue";
+
+const uint32_t PublishQueue::LATENCY_BOUNDS_MS[LATENCY_BUCKETS] = {1,   2,   5,    10,   20,   50,    100,
+                                                                   200, 500, 1000, 2000, 5000, 10000, UINT32_MAX};
+
+void PublishQueue::setup() {
+  for (auto &lane : this->lanes_)
+    lane.slots.resize(lane.capacity);
+}
+
+bool PublishQueue::enqueue(Priority priority, const std::string &topic, const char *payload, size_t len) {
+  auto &lane = this->lanes_[priority];
+  if (lane.count == lane.capacity) {
+    lane.stats.dropped++;
+    ESP_LOGW(TAG, "Publish queue full (%u messages), dropping message to %s", (unsigned) lane.capacity,
+             topic.c_str());
+    return false;
+  }
+  auto &message = lane.slots[(lane.head + lane.count) % lane.capacity];
+  message.topic.assign(topic);
+  message.payload.assign(payload, len);
+  message.enqueued_us = esp_timer_get_time();
+  message.refused_since_us = 0;
+  lane.count++;
+  lane.stats.max_depth = std::max<uint32_t>(lane.stats.max_depth, lane.count);
+  return true;
+}
+
+void PublishQueue::loop() {
+  auto *mqtt = mqtt::global_mqtt_client;
+  if (mqtt == nullptr || !mqtt->is_connected()) {
+    // Not the messages' fault: refusals count again once connected
+    for (auto &lane : this->lanes_) {
+      if (lane.count > 0)
+        lane.slots[lane.head].refused_since_us = 0;
+    }
+    return;
+  }
+
+  const int64_t start = esp_timer_get_time();
+  for (auto &lane : this->lanes_) {
+    while (lane.count > 0) {
+      auto &message = lane.slots[lane.head];
+      const bool sent = mqtt->publish(message.topic, message.payload.data(), message.payload.size());
+      const int64_t now = esp_timer_get_time();
+      if (!sent) {
+        lane.stats.refused++;
+        if (message.refused_since_us == 0)
+          message.refused_since_us = now;
+        // Client buffer full: keep it and retry on the next loop()
+        if (now - message.refused_since_us < REFUSED_TIMEOUT_US)
+          return;
+        ESP_LOGW(TAG, "Dropping message to %s (%zu bytes), refused by the MQTT client for %u s",
+                 message.topic.c_str(), message.payload.size(), (unsigned) (REFUSED_TIMEOUT_US / 1000000));
+        lane.stats.dropped++;
+        this->pop_(lane);
+        return;
+      }
+      this->record_latency_((uint32_t) ((now - message.enqueued_us) / 1000));
+      this->pop_(lane);
+      lane.stats.published++;
+      if (now - start >= this->loop_budget_us_)
+        return;
+    }
+  }
+}
+
+void PublishQueue::pop_(Lane &lane) {
+  lane.head = (lane.head + 1) % lane.capacity;
+  lane.count--;
+}
+
+void PublishQueue::record_latency_(uint32_t latency_ms) {
+  size_t bucket = 0;
+  while (latency_ms > LATENCY_BOUNDS_MS[bucket])
+    bucket++;
+  this->latency_histogram_[bucket]++;
+  this->latency_samples_++;
+  this->latency_max_ms_ = std::max(this->latency_max_ms_, latency_ms);
+}
+
+uint32_t PublishQueue::latency_percentile_ms(float share) const {
+  if (this->latency_samples_ == 0)
+    return 0;
+  // Nearest rank: the smallest latency with `share` of the samples at or below it
+  const uint32_t rank = std::max<uint32_t>(1, (uint32_t) std::ceil(share * this->latency_samples_));
+  uint32_t seen = 0;
+  for (size_t bucket = 0; bucket < LATENCY_BUCKETS; bucket++) {
+    seen += this->latency_histogram_[bucket];
+    if (seen >= rank)
+      return std::min(LATENCY_BOUNDS_MS[bucket], this->latency_max_ms_);
+  }
+  return this->latency_max_ms_;
+}
+
+void PublishQueue::reset_stats() {
+  for (auto &lane : this->lanes_)
+    lane.stats = {};
+  this->latency_histogram_.fill(0);
+  this->latency_samples_ = 0;
+  this->latency_max_ms_ = 0;
+}
+
+} // namespace wmbus_radio
+} // namespace esphome
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace esphome {
+namespace wmbus_radio {
+
+// Bounded outbound MQTT queue, drained from loop() within a time budget, so
+// a slow broker delays publishing instead of frame processing. Telegrams go
+// out before diagnostics. Message buffers are reused: nothing is allocated
+// once every slot has held its largest message.
+class PublishQueue {
+public:
+  enum Priority : uint8_t {
+    PRIORITY_TELEGRAM,
+    PRIORITY_DIAGNOSTIC,
+    PRIORITY_COUNT,
+  };
+
+  void set_capacity(Priority priority, size_t capacity) { this->lanes_[priority].capacity = capacity; }
+  // Publishing stops for this loop() once the budget is used (at least one
+  // message is always attempted)
+  void set_loop_budget_us(uint32_t budget_us) { this->loop_budget_us_ = budget_us; }
+  void setup();
+
+  // A message the connected client keeps refusing for this long (e.g. too
+  // big for its buffer) is dropped, so it cannot block its lane for good
+  static constexpr int64_t REFUSED_TIMEOUT_US = 10 * 1000 * 1000;
+
+  // False (and counted as dropped) if the queue of that priority is full
+  bool enqueue(Priority priority, const std::string &topic, const char *payload, size_t len);
+  bool enqueue(Priority priority, const std::string &topic, const std::string &payload) {
+    return this->enqueue(priority, topic, payload.data(), payload.size());
+  }
+  void loop();
+
+  struct LaneStats {
+    uint32_t published{0};
+    // Queue full, or refused for REFUSED_TIMEOUT_US
+    uint32_t dropped{0};
+    // Publish attempts the client refused while connected
+    uint32_t refused{0};
+    uint32_t max_depth{0};
+  };
+  const LaneStats &stats(Priority priority) const { return this->lanes_[priority].stats; }
+  size_t depth(Priority priority) const { return this->lanes_[priority].count; }
+  // Upper bound of the histogram bucket holding the given share of the
+  // publish latencies (time from enqueue to a successful publish)
+  uint32_t latency_percentile_ms(float share) const;
+  uint32_t latency_max_ms() const { return this->latency_max_ms_; }
+  void reset_stats();
+
+protected:
+  struct Message {
+    std::string topic;
+    std::string payload;
+    int64_t enqueued_us;
+    // First refusal while connected, 0 if none
+    int64_t refused_since_us;
+  };
+  struct Lane {
+    size_t capacity{0};
+    std::vector<Message> slots;
+    size_t head{0};  // oldest message
+    size_t count{0};
+    LaneStats stats;
+  };
+
+  static constexpr size_t LATENCY_BUCKETS = 14;
+  static const uint32_t LATENCY_BOUNDS_MS[LATENCY_BUCKETS];
+  void record_latency_(uint32_t latency_ms);
+  void pop_(Lane &lane);
+
+  std::array<Lane, PRIORITY_COUNT> lanes_;
+  uint32_t loop_budget_us_{5000};
+  std::array<uint32_t, LATENCY_BUCKETS> latency_histogram_{};
+  uint32_t latency_samples_{0};
+  uint32_t latency_max_ms_{0};
+};
+
+} // namespace wmbus_radio
+} // namespace esphome
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace esphome {
+namespace wmbus_radio {
+
+// Bounded lock-free ring for exactly one producer task and one consumer task.
+// Storage is allocated once in init(); push()/pop() never allocate or block.
+template <typename T> class SpscRing {
+public:
+  void init(size_t capacity) {
+    // One slot stays unused to tell "full" from "empty".
+    this->slots_.assign(capacity + 1, T{});
+    this->head_.store(0, std::memory_order_relaxed);
+    this->tail_.store(0, std::memory_order_relaxed);
+  }
+
+  size_t capacity() const { return this->slots_.empty() ? 0 : this->slots_.size() - 1; }
+
+  // Producer side. Returns false if the ring is full.
+  bool push(const T &item) {
+    const size_t head = this->head_.load(std::memory_order_relaxed);
+    const size_t next = this->next_(head);
+    if (next == this->tail_.load(std::memory_order_acquire))
+      return false;
+    this->slots_[head] = item;
+    this->head_.store(next, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side. Returns false if the ring is empty.
+  bool pop(T &item) {
+    const size_t tail = this->tail_.load(std::memory_order_relaxed);
+    if (tail == this->head_.load(std::memory_order_acquire))
+      return false;
+    item = this->slots_[tail];
+    this->tail_.store(this->next_(tail), std::memory_order_release);
+    return true;
+  }
+
+  // Approximate when called concurrently with push()/pop().
+  size_t size() const {
+    const size_t head = this->head_.load(std::memory_order_acquire);
+    const size_t tail = this->tail_.load(std::memory_order_acquire);
+    return head >= tail ? head - tail : head + this->slots_.size() - tail;
+  }
+
+protected:
+  size_t next_(size_t index) const { return index + 1 == this->slots_.size() ? 0 : index + 1; }
+
+  std::vector<T> slots_;
+  std::atomic<size_t> head_{0};
+  std::atomic<size_t> tail_{0};
+};
+
+} // namespace wmbus_radio
+} // namespace esphome
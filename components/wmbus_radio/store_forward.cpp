@@ -0,0 +1,264 @@
+#include "store_forward.h"
+
+#include <algorithm>
+#include <unistd.h>
+
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/log.h"
+
+#include "esphome/components/mqtt/mqtt_client.h"
+
+#ifdef USE_WMBUS_LITTLEFS
+#include "esp_littlefs.h"
+#endif
+
+namespace esphome {
+namespace wmbus_radio {
+static const char *const TAG = "wmbus_radio.store_forward";
+
+bool StoreForward::setup() {
+  if (this->ram_size_ == 0 || this->ram_ != nullptr)
+    return false;
+  RAMAllocator<uint8_t> allocator(this->in_psram_ ? RAMAllocator<uint8_t>::NONE
+                                                  : RAMAllocator<uint8_t>::ALLOC_INTERNAL);
+  this->ram_ = allocator.allocate(this->ram_size_);
+  if (this->ram_ == nullptr) {
+    ESP_LOGE(TAG, "Cannot allocate %zu bytes", this->ram_size_);
+    return false;
+  }
+  this->backlog_since_ms_ = millis();
+  if (!this->spill_path_.empty() && this->open_spill_() && this->file_records_ > 0)
+    ESP_LOGI(TAG, "%u telegrams left in %s from before the restart", (unsigned) this->file_records_,
+             this->spill_path_.c_str());
+  return true;
+}
+
+bool StoreForward::mount_littlefs(const char *partition, const char *base_path) {
+#ifdef USE_WMBUS_LITTLEFS
+  esp_vfs_littlefs_conf_t conf = {};
+  conf.base_path = base_path;
+  conf.partition_label = partition;
+  conf.format_if_mount_failed = true;
+  const esp_err_t err = esp_vfs_littlefs_register(&conf);
+  if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+    ESP_LOGE(TAG, "Cannot mount LittleFS partition '%s': %s", partition, esp_err_to_name(err));
+    return false;
+  }
+  return true;
+#else
+  ESP_LOGE(TAG, "Built without LittleFS support");
+  return false;
+#endif
+}
+
+bool StoreForward::should_store() const {
+  if (this->ram_ == nullptr)
+    return false;
+  if (this->has_backlog())
+    return true;
+  auto *mqtt = mqtt::global_mqtt_client;
+  return mqtt == nullptr || !mqtt->is_connected();
+}
+
+bool StoreForward::open_spill_() {
+  this->file_ = fopen(this->spill_path_.c_str(), "a+b");
+  if (this->file_ == nullptr) {
+    ESP_LOGW(TAG, "Cannot open %s, flash spill disabled", this->spill_path_.c_str());
+    return false;
+  }
+  fseek(this->file_, 0, SEEK_END);
+  const size_t end = ftell(this->file_);
+  fseek(this->file_, 0, SEEK_SET);
+
+  // Count the records left over; a record cut short by a reset is dropped
+  size_t pos = 0;
+  uint8_t header[RECORD_HEADER_SIZE];
+  while (fread(header, 1, sizeof(header), this->file_) == sizeof(header)) {
+    const size_t size = sizeof(header) + (header[0] | header[1] << 8) + (header[2] | header[3] << 8);
+    if (pos + size > end)
+      break;
+    pos += size;
+    this->file_records_++;
+    fseek(this->file_, pos, SEEK_SET);
+  }
+  if (pos != end) {
+    ESP_LOGW(TAG, "Dropping %u bytes of an incomplete record", (unsigned) (end - pos));
+    this->close_spill_();
+    if (truncate(this->spill_path_.c_str(), pos) != 0) {
+      remove(this->spill_path_.c_str());
+      pos = 0;
+      this->file_records_ = 0;
+    }
+    this->file_ = fopen(this->spill_path_.c_str(), "a+b");
+    if (this->file_ == nullptr)
+      return false;
+  }
+  this->file_size_ = pos;
+  this->file_read_ = 0;
+  return true;
+}
+
+void StoreForward::close_spill_() {
+  if (this->file_ != nullptr)
+    fclose(this->file_);
+  this->file_ = nullptr;
+}
+
+void StoreForward::ram_write_(size_t pos, const void *data, size_t len) {
+  pos %= this->ram_size_;
+  const size_t first = std::min(len, this->ram_size_ - pos);
+  memcpy(this->ram_ + pos, data, first);
+  memcpy(this->ram_, static_cast<const uint8_t *>(data) + first, len - first);
+}
+
+void StoreForward::ram_read_(size_t pos, void *data, size_t len) const {
+  pos %= this->ram_size_;
+  const size_t first = std::min(len, this->ram_size_ - pos);
+  memcpy(data, this->ram_ + pos, first);
+  memcpy(static_cast<uint8_t *>(data) + first, this->ram_, len - first);
+}
+
+bool StoreForward::store(const std::string &topic, const char *payload, size_t len) {
+  if (this->ram_ == nullptr)
+    return false;
+  if (topic.size() > UINT16_MAX || len > UINT16_MAX) {
+    this->dropped_++;
+    return false;
+  }
+  const size_t size = RECORD_HEADER_SIZE + topic.size() + len;
+  if (!this->has_backlog())
+    this->backlog_since_ms_ = millis();
+  // Live traffic queued behind the backlog: replay it on top of the rate
+  auto *mqtt = mqtt::global_mqtt_client;
+  const bool live = mqtt != nullptr && mqtt->is_connected();
+  const uint8_t header[RECORD_HEADER_SIZE] = {(uint8_t) topic.size(), (uint8_t) (topic.size() >> 8), (uint8_t) len,
+                                              (uint8_t) (len >> 8)};
+
+  // RAM while nothing waits in the file (keeps the order)
+  if (this->file_records_ == 0 && this->ram_used_ + size <= this->ram_size_) {
+    const size_t tail = this->ram_head_ + this->ram_used_;
+    this->ram_write_(tail, header, sizeof(header));
+    this->ram_write_(tail + sizeof(header), topic.data(), topic.size());
+    this->ram_write_(tail + sizeof(header) + topic.size(), payload, len);
+    this->ram_used_ += size;
+    this->ram_records_++;
+    this->stored_++;
+    this->live_credit_ += live;
+    return true;
+  }
+
+  if (this->file_ != nullptr && this->file_size_ + size <= this->spill_max_bytes_) {
+    fseek(this->file_, 0, SEEK_END);
+    const bool ok = fwrite(header, 1, sizeof(header), this->file_) == sizeof(header) &&
+                    fwrite(topic.data(), 1, topic.size(), this->file_) == topic.size() &&
+                    fwrite(payload, 1, len, this->file_) == len && fflush(this->file_) == 0;
+    if (ok) {
+      this->file_size_ += size;
+      this->file_records_++;
+      this->stored_++;
+      this->live_credit_ += live;
+      return true;
+    }
+    ESP_LOGW(TAG, "Cannot write to %s", this->spill_path_.c_str());
+  }
+
+  this->dropped_++;
+  ESP_LOGW(TAG, "Store full (%u telegrams waiting), dropping telegram to %s", (unsigned) this->backlog(),
+           topic.c_str());
+  return false;
+}
+
+bool StoreForward::peek_() {
+  if (this->peeked_)
+    return true;
+  uint8_t header[RECORD_HEADER_SIZE];
+  if (this->ram_records_ > 0) {
+    this->ram_read_(this->ram_head_, header, sizeof(header));
+    const size_t topic_len = header[0] | header[1] << 8;
+    const size_t payload_len = header[2] | header[3] << 8;
+    this->topic_.resize(topic_len);
+    this->payload_.resize(payload_len);
+    this->ram_read_(this->ram_head_ + sizeof(header), &this->topic_[0], topic_len);
+    this->ram_read_(this->ram_head_ + sizeof(header) + topic_len, &this->payload_[0], payload_len);
+    this->peeked_from_file_ = false;
+    this->peeked_size_ = sizeof(header) + topic_len + payload_len;
+  } else if (this->file_records_ > 0) {
+    fseek(this->file_, this->file_read_, SEEK_SET);
+    if (fread(header, 1, sizeof(header), this->file_) != sizeof(header))
+      return false;
+    const size_t topic_len = header[0] | header[1] << 8;
+    const size_t payload_len = header[2] | header[3] << 8;
+    this->topic_.resize(topic_len);
+    this->payload_.resize(payload_len);
+    if (fread(&this->topic_[0], 1, topic_len, this->file_) != topic_len ||
+        fread(&this->payload_[0], 1, payload_len, this->file_) != payload_len)
+      return false;
+    this->peeked_from_file_ = true;
+    this->peeked_size_ = sizeof(header) + topic_len + payload_len;
+  } else {
+    return false;
+  }
+  this->peeked_ = true;
+  return true;
+}
+
+void StoreForward::pop_() {
+  this->peeked_ = false;
+  if (!this->peeked_from_file_) {
+    this->ram_head_ = (this->ram_head_ + this->peeked_size_) % this->ram_size_;
+    this->ram_used_ -= this->peeked_size_;
+    this->ram_records_--;
+    return;
+  }
+  this->file_read_ += this->peeked_size_;
+  if (--this->file_records_ > 0)
+    return;
+  // Everything replayed: start over with an empty file
+  this->close_spill_();
+  remove(this->spill_path_.c_str());
+  this->file_size_ = 0;
+  this->file_read_ = 0;
+  this->file_ = fopen(this->spill_path_.c_str(), "a+b");
+}
+
+void StoreForward::loop(uint32_t now_ms) {
+  // Replay budget: replay_rate per second, at most one second's worth saved
+  // up, plus one for every telegram stored while connected
+  const uint32_t elapsed_ms = now_ms - this->last_replay_ms_;
+  this->last_replay_ms_ = now_ms;
+  this->replay_tokens_ =
+      std::min<float>(this->replay_rate_, this->replay_tokens_ + elapsed_ms * this->replay_rate_ / 1000.0f);
+  if (!this->has_backlog()) {
+    this->live_credit_ = 0;
+    return;
+  }
+
+  auto *mqtt = mqtt::global_mqtt_client;
+  if (mqtt == nullptr || !mqtt->is_connected())
+    return;
+  while ((this->live_credit_ > 0 || this->replay_tokens_ >= 1.0f) && this->has_backlog()) {
+    if (!this->peek_()) {
+      // Unreadable file: give up on it rather than retrying forever
+      ESP_LOGE(TAG, "Cannot read %s, dropping %u telegrams", this->spill_path_.c_str(),
+               (unsigned) this->file_records_);
+      this->dropped_ += this->file_records_;
+      this->file_records_ = 1;
+      this->peeked_from_file_ = true;
+      this->peeked_size_ = 0;
+      this->pop_();
+      continue;
+    }
+    if (!mqtt->publish(this->topic_, this->payload_.data(), this->payload_.size()))
+      return;
+    this->pop_();
+    this->replayed_++;
+    if (this->live_credit_ > 0)
+      this->live_credit_--;
+    else
+      this->replay_tokens_ -= 1.0f;
+  }
+}
+
+} // namespace wmbus_radio
+} // namespace esphome
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace esphome {
+namespace wmbus_radio {
+
+// Keeps telegrams that could not be published (MQTT down) and replays them,
+// oldest first and at a limited rate, once the broker is back. Telegrams
+// stored behind the backlog while connected raise that rate by one each, so
+// the backlog drains at the configured rate however busy the site is.
+//
+// Messages go to a RAM ring (PSRAM if available). When it is full they are
+// appended to an optional log file on flash, which also survives a reboot.
+// Once anything is in the file, new messages follow it there, so the replay
+// order is the reception order. Replay is at-least-once: a reboot during a
+// replay repeats the part of the file already sent.
+//
+// Both stores hold records of: u16 topic length, u16 payload length, topic,
+// payload (lengths little-endian).
+class StoreForward {
+public:
+  void set_ram_size(size_t bytes) { this->ram_size_ = bytes; }
+  void set_in_psram(bool enabled) { this->in_psram_ = enabled; }
+  // Log file on a mounted filesystem, capped at max_bytes
+  void set_spill(const std::string &path, size_t max_bytes) {
+    this->spill_path_ = path;
+    this->spill_max_bytes_ = max_bytes;
+  }
+  // Mounts LittleFS from `partition` at `base_path` (USE_WMBUS_LITTLEFS only)
+  static bool mount_littlefs(const char *partition, const char *base_path);
+  void set_replay_rate(uint16_t per_second) { this->replay_rate_ = per_second; }
+  bool setup();
+  bool is_enabled() const { return this->ram_ != nullptr; }
+
+  bool has_backlog() const { return this->ram_records_ > 0 || this->file_records_ > 0; }
+  // New messages must be stored rather than published while the broker is
+  // unreachable or older ones are still waiting (keeps them in order)
+  bool should_store() const;
+  // False (and counted as dropped) if neither store has room
+  bool store(const std::string &topic, const char *payload, size_t len);
+  // Replays stored messages while MQTT is connected
+  void loop(uint32_t now_ms);
+
+  uint32_t backlog() const { return this->ram_records_ + this->file_records_; }
+  // How long the store has not been empty
+  uint32_t backlog_age_ms(uint32_t now_ms) const {
+    return this->has_backlog() ? now_ms - this->backlog_since_ms_ : 0;
+  }
+  size_t ram_bytes() const { return this->ram_used_; }
+  size_t file_bytes() const { return this->file_size_ - this->file_read_; }
+  // Per summary window
+  uint32_t stored() const { return this->stored_; }
+  uint32_t replayed() const { return this->replayed_; }
+  uint32_t dropped() const { return this->dropped_; }
+  void reset_stats() {
+    this->stored_ = 0;
+    this->replayed_ = 0;
+    this->dropped_ = 0;
+  }
+
+protected:
+  static constexpr size_t RECORD_HEADER_SIZE = 4;
+
+  void ram_write_(size_t pos, const void *data, size_t len);
+  void ram_read_(size_t pos, void *data, size_t len) const;
+  // Loads the oldest record into topic_/payload_ (false if none or unreadable)
+  bool peek_();
+  void pop_();
+  bool open_spill_();
+  void close_spill_();
+
+  uint8_t *ram_{nullptr};
+  size_t ram_size_{0};
+  bool in_psram_{true};
+  size_t ram_head_{0};  // oldest record
+  size_t ram_used_{0};
+  uint32_t ram_records_{0};
+
+  std::string spill_path_;
+  size_t spill_max_bytes_{0};
+  FILE *file_{nullptr};
+  size_t file_size_{0};
+  size_t file_read_{0};  // replayed up to here
+  uint32_t file_records_{0};
+
+  // Record being replayed
+  std::string topic_;
+  std::string payload_;
+  bool peeked_{false};
+  bool peeked_from_file_{false};
+  size_t peeked_size_{0};
+
+  uint16_t replay_rate_{10};
+  float replay_tokens_{0};
+  // Telegrams stored while connected, replayed on top of replay_rate
+  uint32_t live_credit_{0};
+  uint32_t last_replay_ms_{0};
+  uint32_t backlog_since_ms_{0};
+
+  uint32_t stored_{0};
+  uint32_t replayed_{0};
+  uint32_t dropped_{0};
+};
+
+} // namespace wmbus_radio
+} // namespace esphome
@@ -0,0 +1,230 @@
+#include "telegram_publisher.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "esphome/core/hal.h"
+#include "esphome/core/log.h"
+
+#include "esphome/components/mqtt/mqtt_client.h"
+
+namespace esphome {
+namespace wmbus_radio {
+static const char *const TAG = "wmbus_radio.publisher";
+
+void TelegramPublisher::setup() {
+  if (this->format_ == Frame::FORMAT_DELTA)
+    this->delta_.init(this->delta_meters_, this->delta_keyframe_interval_);
+}
+
+bool TelegramPublisher::serialize_(Frame *frame, const char *&payload, size_t &len, bool keyframe) {
+  if (this->format_ == Frame::FORMAT_HEX) {
+    // Shares the rendering with on_frame automations calling frame->hex()
+    const std::string &hex = frame->hex();
+    payload = hex.data();
+    len = hex.size();
+    return true;
+  }
+
+  size_t needed;
+  switch (this->format_) {
+    case Frame::FORMAT_RTLWMBUS:
+      needed = frame->rtlwmbus_buffer_size();
+      break;
+    case Frame::FORMAT_BINARY:
+      needed = frame->binary_buffer_size();
+      break;
+    case Frame::FORMAT_DELTA:
+      needed = DeltaEncoder::buffer_size(*frame);
+      break;
+    default:
+      needed = frame->cbor_buffer_size();
+      break;
+  }
+  if (this->buffer_.size() < needed)
+    this->buffer_.resize(needed);
+
+  auto *out = this->buffer_.data();
+  switch (this->format_) {
+    case Frame::FORMAT_RTLWMBUS:
+      len = frame->write_rtlwmbus(reinterpret_cast<char *>(out), needed);
+      break;
+    case Frame::FORMAT_BINARY:
+      len = frame->write_binary(out, needed);
+      break;
+    case Frame::FORMAT_DELTA:
+      len = this->delta_.encode(frame, out, needed, keyframe);
+      break;
+    default:
+      len = frame->write_cbor(out, needed);
+      break;
+  }
+  payload = reinterpret_cast<const char *>(out);
+  return len > 0;
+}
+
+bool TelegramPublisher::send_(const std::string &topic, const char *payload, size_t len, uint32_t frames,
+                              bool direct) {
+  if (this->store_ != nullptr && this->store_->should_store())
+    return this->keep_(topic, payload, len, frames);
+  if (this->queue_ != nullptr && !direct) {
+    if (!this->queue_->enqueue(PublishQueue::PRIORITY_TELEGRAM, topic, payload, len)) {
+      this->failed_ += frames;
+      return false;
+    }
+    this->published_ += frames;
+    return true;
+  }
+  auto *mqtt = mqtt::global_mqtt_client;
+  if (mqtt == nullptr || !mqtt->is_connected() || !mqtt->publish(topic, payload, len)) {
+    if (this->store_ != nullptr)
+      return this->keep_(topic, payload, len, frames);
+    ESP_LOGW(TAG, "Failed to publish %u telegram(s) to %s", (unsigned) frames, topic.c_str());
+    this->failed_ += frames;
+    return false;
+  }
+  this->published_ += frames;
+  return true;
+}
+
+bool TelegramPublisher::keep_(const std::string &topic, const char *payload, size_t len, uint32_t frames) {
+  if (!this->store_->store(topic, payload, len)) {
+    this->failed_ += frames;
+    return false;
+  }
+  this->published_ += frames;
+  return true;
+}
+
+bool TelegramPublisher::publish(Frame *frame) {
+  const char *payload;
+  size_t len;
+  if (!this->serialize_(frame, payload, len)) {
+    this->failed_++;
+    return false;
+  }
+  if (this->topic_per_meter_)
+    return this->send_(this->meter_topic_for_(frame), payload, len, 1);
+  if (!this->is_batching())
+    return this->send_(this->topic_, payload, len, 1);
+
+  this->add_to_batch_(payload, len, millis());
+  return true;
+}
+
+bool TelegramPublisher::publish_now(Frame *frame) {
+  const char *payload;
+  size_t len;
+  if (!this->serialize_(frame, payload, len, true)) {
+    this->failed_++;
+    return false;
+  }
+  if (this->topic_per_meter_)
+    return this->send_(this->meter_topic_for_(frame), payload, len, 1, true);
+  if (!this->is_batching())
+    return this->send_(this->topic_, payload, len, 1, true);
+
+  // Alone, as a batch of one so consumers need no special case. The pending
+  // batch keeps its timer and goes through the queue as usual.
+  this->single_.clear();
+  this->append_batch_item_(this->single_, payload, len, true);
+  this->close_batch_(this->single_);
+  return this->send_(this->topic_, this->single_.data(), this->single_.size(), 1, true);
+}
+
+const std::string &TelegramPublisher::meter_topic_for_(Frame *frame) {
+  const auto &header = frame->header();
+  char suffix[15];
+  snprintf(suffix, sizeof(suffix), "/%s/%08x", header.manufacturer_code, (unsigned) header.id);
+  this->meter_topic_.assign(this->topic_).append(suffix);
+  return this->meter_topic_;
+}
+
+size_t TelegramPublisher::batch_item_size_(size_t len) const {
+  switch (this->format_) {
+    case Frame::FORMAT_HEX:
+      return len + 3;  // '[' or ',' and the quotes
+    case Frame::FORMAT_RTLWMBUS:
+      return len;
+    default:
+      return len + 2;
+  }
+}
+
+void TelegramPublisher::add_to_batch_(const char *item, size_t len, uint32_t now_ms) {
+  const size_t item_size = this->batch_item_size_(len);
+  if (this->batch_count_ > 0 &&
+      this->batch_.size() + item_size + this->batch_trailer_size_() > this->batch_max_bytes_)
+    this->flush_batch_(FLUSH_FULL);
+
+  if (this->batch_count_ == 0) {
+    // Grows once to the batch size (or the largest single frame above it)
+    this->batch_.reserve(std::max(this->batch_max_bytes_, item_size + this->batch_trailer_size_()));
+    this->batch_started_ms_ = now_ms;
+  }
+
+  this->append_batch_item_(this->batch_, item, len, this->batch_count_ == 0);
+  this->batch_count_++;
+
+  // No room left for even a minimal frame: don't wait for the timeout
+  if (this->batch_.size() + this->batch_item_size_(0) + this->batch_trailer_size_() >= this->batch_max_bytes_)
+    this->flush_batch_(FLUSH_FULL);
+}
+
+void TelegramPublisher::append_batch_item_(std::string &batch, const char *item, size_t len, bool first) const {
+  switch (this->format_) {
+    case Frame::FORMAT_HEX:
+      batch += first ? '[' : ',';
+      batch += '"';
+      batch.append(item, len);
+      batch += '"';
+      break;
+    case Frame::FORMAT_RTLWMBUS:
+      batch.append(item, len);
+      break;
+    default:
+      batch += (char) (len >> 8);
+      batch += (char) (len & 0xFF);
+      batch.append(item, len);
+      break;
+  }
+}
+
+void TelegramPublisher::close_batch_(std::string &batch) const {
+  if (this->format_ == Frame::FORMAT_HEX)
+    batch += ']';
+}
+
+void TelegramPublisher::flush_batch_(FlushReason reason) {
+  if (this->batch_count_ == 0)
+    return;
+  this->close_batch_(this->batch_);
+
+  auto &stats = this->batch_stats_;
+  stats.batches++;
+  stats.frames += this->batch_count_;
+  stats.bytes += this->batch_.size();
+  stats.max_frames = std::max(stats.max_frames, this->batch_count_);
+  switch (reason) {
+    case FLUSH_FULL:
+      stats.flushed_full++;
+      break;
+    case FLUSH_TIMEOUT:
+      stats.flushed_timeout++;
+      break;
+  }
+
+  ESP_LOGD(TAG, "Publishing batch of %u telegrams (%zu bytes)", (unsigned) this->batch_count_,
+           this->batch_.size());
+  this->send_(this->topic_, this->batch_.data(), this->batch_.size(), this->batch_count_);
+  this->batch_.clear();
+  this->batch_count_ = 0;
+}
+
+void TelegramPublisher::loop(uint32_t now_ms) {
+  if (this->batch_count_ > 0 && now_ms - this->batch_started_ms_ >= this->batch_max_delay_ms_)
+    this->flush_batch_(FLUSH_TIMEOUT);
+}
+
+} // namespace wmbus_radio
+} // namespace esphome
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "delta_encoder.h"
+#include "packet.h"
+#include "publish_queue.h"
+#include "store_forward.h"
+
+namespace esphome {
+namespace wmbus_radio {
+
+// Publishes every accepted frame to one MQTT topic in the configured format.
+// Frames are serialized into a buffer that is reused for every frame.
+//
+// With batching enabled, frames are collected for up to `max_delay_ms` or
+// `max_bytes` and published as one message:
+//  - hex:            JSON array of strings
+//  - rtlwmbus:       the lines, one after another
+//  - binary, cbor, delta: each item prefixed with its length (u16, big-endian)
+class TelegramPublisher {
+public:
+  void set_topic(const std::string &topic) { this->topic_ = topic; }
+  void set_format(Frame::OutputFormat format) { this->format_ = format; }
+  // Batching is disabled while max_bytes is 0
+  void set_batch(uint32_t max_delay_ms, size_t max_bytes) {
+    this->batch_max_delay_ms_ = max_delay_ms;
+    this->batch_max_bytes_ = max_bytes;
+  }
+  // Publish to <topic>/<manufacturer>/<id> (e.g. wmbus/KAM/12345678) so
+  // consumers can subscribe to single meters. Not combined with batching.
+  void set_topic_per_meter(bool enabled) { this->topic_per_meter_ = enabled; }
+  // Meters remembered and keyframe interval for FORMAT_DELTA
+  void set_delta(uint16_t meters, uint8_t keyframe_interval) {
+    this->delta_meters_ = meters;
+    this->delta_keyframe_interval_ = keyframe_interval;
+  }
+  // Hand messages to `queue` instead of publishing them directly
+  void set_queue(PublishQueue *queue) { this->queue_ = queue; }
+  // Keep messages in `store` while the broker is unreachable
+  void set_store(StoreForward *store) { this->store_ = store; }
+  void setup();
+  bool is_enabled() const { return !this->topic_.empty(); }
+  bool is_batching() const { return this->batch_max_bytes_ > 0; }
+
+  // Returns false if the frame could not be handed to the MQTT client.
+  // When batching, the frame is only queued: failures are counted at flush.
+  bool publish(Frame *frame);
+  // Publishes right away, past the publish queue. When batching, the frame
+  // goes out alone as a batch of one and the pending batch stays pending, so
+  // it may arrive before frames received earlier. Delta messages are
+  // keyframes, as earlier ones may still be queued.
+  bool publish_now(Frame *frame);
+  // Publishes the pending batch once it is older than max_delay
+  void loop(uint32_t now_ms);
+
+  // Frames, not messages. With a queue: frames queued and dropped by it.
+  // Frames kept by the store for later count as published.
+  uint32_t published() const { return this->published_; }
+  uint32_t failed() const { return this->failed_; }
+
+  struct BatchStats {
+    uint32_t batches{0};
+    uint32_t frames{0};
+    uint32_t bytes{0};
+    uint32_t max_frames{0};
+    // Why batches were published
+    uint32_t flushed_full{0};
+    uint32_t flushed_timeout{0};
+  };
+  const BatchStats &batch_stats() const { return this->batch_stats_; }
+  const DeltaEncoder &delta() const { return this->delta_; }
+
+  void reset_stats() {
+    this->published_ = 0;
+    this->failed_ = 0;
+    this->batch_stats_ = {};
+  }
+
+protected:
+  // Frame in the configured format, pointing at the frame's hex cache or
+  // at buffer_. Returns false if it could not be serialized.
+  bool serialize_(Frame *frame, const char *&payload, size_t &len, bool keyframe = false);
+  // `direct` skips the publish queue
+  bool send_(const std::string &topic, const char *payload, size_t len, uint32_t frames, bool direct = false);
+  // Hands the message to store_ for a later replay
+  bool keep_(const std::string &topic, const char *payload, size_t len, uint32_t frames);
+
+  void add_to_batch_(const char *item, size_t len, uint32_t now_ms);
+  // Appends `item` with its framing; `first` opens the batch
+  void append_batch_item_(std::string &batch, const char *item, size_t len, bool first) const;
+  void close_batch_(std::string &batch) const;
+  enum FlushReason : uint8_t { FLUSH_FULL, FLUSH_TIMEOUT };
+  void flush_batch_(FlushReason reason);
+  // <topic>/<manufacturer>/<id>, rebuilt in meter_topic_
+  const std::string &meter_topic_for_(Frame *frame);
+  // Bytes an item of `len` bytes takes in the batch, including its framing
+  size_t batch_item_size_(size_t len) const;
+  // Bytes needed to close a batch
+  size_t batch_trailer_size_() const { return this->format_ == Frame::FORMAT_HEX ? 1 : 0; }
+
+  std::string topic_;
+  PublishQueue *queue_{nullptr};
+  StoreForward *store_{nullptr};
+  bool topic_per_meter_{false};
+  // Per-meter topic, rebuilt in place for every frame
+  std::string meter_topic_;
+  Frame::OutputFormat format_{Frame::FORMAT_HEX};
+  std::vector<uint8_t> buffer_;
+  DeltaEncoder delta_;
+  uint16_t delta_meters_{32};
+  uint8_t delta_keyframe_interval_{10};
+
+  uint32_t batch_max_delay_ms_{0};
+  size_t batch_max_bytes_{0};
+  std::string batch_;
+  // Batch of one for publish_now(), reused so the urgent path does not allocate
+  std::string single_;
+  uint32_t batch_count_{0};
+  uint32_t batch_started_ms_{0};
+
+  uint32_t published_{0};
+  uint32_t failed_{0};
+  BatchStats batch_stats_;
+};
+
+} // namespace wmbus_radio
+} // namespace esphome
@@ -0,0 +1,213 @@
+// Microbenchmarks for the radio packet path: 3-of-6 decoding, size checks,
+// frame conversion (decode + DLL CRC removal) and the text serializers, plus
+// the encoder that builds test packets.
+//
+//   wmbus_bench [--iterations N] [--filter TEXT]
+//
+// Prints ns and heap allocations per frame for each case and frame size.
+// Frame size is the L-field + 1 (the frame without DLL CRCs). "convert" and
+// "expected_size" rows include copying the raw bytes into the packet, which
+// the "load" row measures on its own.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "decode3of6.h"
+#include "dll_crc.h"
+#include "frame_encoder.h"
+#include "packet.h"
+
+#include "frame_builder.h"
+
+using namespace esphome::wmbus_radio;
+using namespace wmbus_host;
+
+// Heap allocations made by the code under test. Every form of new and
+// delete is replaced, so each allocation is counted and freed by the same
+// allocator.
+static size_t allocations = 0;
+
+static void *counted_malloc(size_t size, size_t alignment = 0) noexcept {
+  allocations++;
+  if (size == 0)
+    size = 1;
+  if (alignment == 0)
+    return std::malloc(size);
+  // aligned_alloc wants a multiple of the alignment
+  return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+static void *counted_new(size_t size, size_t alignment = 0) {
+  if (void *p = counted_malloc(size, alignment))
+    return p;
+  throw std::bad_alloc();
+}
+
+void *operator new(size_t size) { return counted_new(size); }
+void *operator new[](size_t size) { return counted_new(size); }
+void *operator new(size_t size, std::align_val_t al) { return counted_new(size, (size_t) al); }
+void *operator new[](size_t size, std::align_val_t al) { return counted_new(size, (size_t) al); }
+void *operator new(size_t size, const std::nothrow_t &) noexcept { return counted_malloc(size); }
+void *operator new[](size_t size, const std::nothrow_t &) noexcept { return counted_malloc(size); }
+void *operator new(size_t size, std::align_val_t al, const std::nothrow_t &) noexcept {
+  return counted_malloc(size, (size_t) al);
+}
+void *operator new[](size_t size, std::align_val_t al, const std::nothrow_t &) noexcept {
+  return counted_malloc(size, (size_t) al);
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+void operator delete[](void *p, size_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete[](void *p, std::align_val_t, const std::nothrow_t &) noexcept { std::free(p); }
+
+// Keeps results alive so the compiler cannot drop the work
+static volatile size_t sink;
+
+namespace {
+
+void load(Packet &packet, const std::vector<uint8_t> &raw) {
+  packet.reset();
+  std::memcpy(packet.append_space(raw.size()), raw.data(), raw.size());
+}
+
+struct Options {
+  size_t iterations{200000};
+  const char *filter{nullptr};
+};
+
+template<typename F> void run(const Options &options, const char *name, size_t frame_size, F &&body) {
+  if (options.filter != nullptr && std::strstr(name, options.filter) == nullptr)
+    return;
+  for (size_t i = 0; i < options.iterations / 10 + 1; i++)
+    body();
+
+  const size_t allocations_before = allocations;
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < options.iterations; i++)
+    body();
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  const double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+  std::printf("%-22s %6zu %12.1f %10.2f\n", name, frame_size, ns / options.iterations,
+              (double) (allocations - allocations_before) / options.iterations);
+}
+
+void bench_size(const Options &options, size_t size) {
+  const auto frame = make_frame(size, (uint32_t) size);
+  const auto format_a = with_dll_crc(frame, FrameFormat::A);
+  const auto format_b = with_dll_crc(frame, FrameFormat::B);
+  const auto t1_a = encode_packet(frame, LinkMode::T1, FrameFormat::A);
+  const auto t1_b = encode_packet(frame, LinkMode::T1, FrameFormat::B);
+  const auto c1_a = encode_packet(frame, LinkMode::C1, FrameFormat::A);
+  const auto c1_b = encode_packet(frame, LinkMode::C1, FrameFormat::B);
+
+  // Every input must decode, or the numbers would measure the reject path
+  for (const auto *raw : {&t1_a, &t1_b, &c1_a, &c1_b}) {
+    Packet packet;
+    load(packet, *raw);
+    auto decoded = packet.convert_to_frame();
+    if (!decoded || decoded->size() != size) {
+      std::fprintf(stderr, "Frame of %zu bytes does not decode (%s)\n", size,
+                   drop_reason_name(packet.drop_reason()));
+      std::exit(1);
+    }
+  }
+
+  static Packet packet;
+  uint8_t buffer[PACKET_CAPACITY];
+
+  run(options, "load", size, [&] {
+    load(packet, t1_a);
+    sink = packet.size();
+  });
+  run(options, "decode3of6", size, [&] { sink = decode3of6(t1_a.data(), t1_a.size(), buffer); });
+  run(options, "encode3of6", size, [&] { sink = encode3of6(format_a.data(), format_a.size(), buffer); });
+  run(options, "expected_size T1", size, [&] {
+    load(packet, t1_a);
+    sink = packet.expected_size();
+  });
+  run(options, "expected_size C1", size, [&] {
+    load(packet, c1_a);
+    sink = packet.expected_size();
+  });
+  run(options, "strip_crc A", size, [&] {
+    size_t len = format_a.size();
+    std::memcpy(buffer, format_a.data(), len);
+    sink = (size_t) strip_dll_crc_format_a(buffer, len) + len;
+  });
+  run(options, "strip_crc B", size, [&] {
+    size_t len = format_b.size();
+    std::memcpy(buffer, format_b.data(), len);
+    sink = (size_t) strip_dll_crc_format_b(buffer, len) + len;
+  });
+  run(options, "insert_crc A", size, [&] { sink = insert_dll_crc_format_a(frame.data(), frame.size(), buffer); });
+  run(options, "insert_crc B", size, [&] { sink = insert_dll_crc_format_b(frame.data(), frame.size(), buffer); });
+  run(options, "encode T1/A", size, [&] {
+    sink = encode_packet(frame.data(), frame.size(), LinkMode::T1, FrameFormat::A, buffer, sizeof(buffer));
+  });
+  run(options, "encode C1/B", size, [&] {
+    sink = encode_packet(frame.data(), frame.size(), LinkMode::C1, FrameFormat::B, buffer, sizeof(buffer));
+  });
+
+  const struct {
+    const char *name;
+    const std::vector<uint8_t> &raw;
+  } conversions[] = {
+      {"convert T1/A", t1_a},
+      {"convert T1/B", t1_b},
+      {"convert C1/A", c1_a},
+      {"convert C1/B", c1_b},
+  };
+  for (const auto &conversion : conversions) {
+    run(options, conversion.name, size, [&] {
+      load(packet, conversion.raw);
+      sink = packet.convert_to_frame()->size();
+    });
+  }
+
+  load(packet, c1_a);
+  Frame frame_view = *packet.convert_to_frame();
+  char text[2 * PACKET_CAPACITY + 64];
+  run(options, "as_hex", size, [&] { sink = frame_view.as_hex().size(); });
+  run(options, "write_hex", size, [&] { sink = frame_view.write_hex(text, sizeof(text)); });
+  run(options, "as_rtlwmbus", size, [&] { sink = frame_view.as_rtlwmbus().size(); });
+  run(options, "write_rtlwmbus", size, [&] { sink = frame_view.write_rtlwmbus(text, sizeof(text)); });
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  Options options;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+      options.iterations = std::strtoul(argv[++i], nullptr, 10);
+    } else if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+      options.filter = argv[++i];
+    } else {
+      std::fprintf(stderr, "Usage: %s [--iterations N] [--filter TEXT]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (options.iterations == 0)
+    options.iterations = 1;
+
+  std::printf("%-22s %6s %12s %10s\n", "case", "bytes", "ns/frame", "allocs");
+  // Frame sizes (L-field + 1). convert_to_frame() rejects T1 packets under
+  // 60 coded bytes as noise, which rules out frames much shorter than 40.
+  for (size_t size : {40, 80, 160, 250})
+    bench_size(options, size);
+  return 0;
+}
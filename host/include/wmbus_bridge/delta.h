@@ -0,0 +1,107 @@
+#pragma once
+
+// Rebuilds full frames from the messages published with
+// `telegram_format: delta`. Header-only, C++17, no dependencies. The message
+// layout is described in docs/PAYLOAD_FORMATS.md.
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace wmbus_bridge {
+
+class DeltaReassembler {
+public:
+  static constexpr size_t HEADER_SIZE = 14;
+
+  enum class Result {
+    OK,
+    // A delta whose base frame was never seen or was missed (lost message,
+    // consumer started late). Frames of this meter resume at its next
+    // keyframe.
+    MISSING_BASE,
+    MALFORMED,
+  };
+
+  struct Frame {
+    uint16_t manufacturer{0};
+    uint32_t id{0};
+    uint16_t sequence{0};  // low 16 bits of the bridge sequence number
+    int8_t rssi{0};
+    bool keyframe{false};
+    // Frame bytes with DLL CRCs removed, starting with the L-field
+    std::vector<uint8_t> data;
+  };
+
+  Result apply(const uint8_t *msg, size_t len, Frame &out) {
+    if (len < HEADER_SIZE || (msg[0] != 'K' && msg[0] != 'D'))
+      return Result::MALFORMED;
+    const auto u16 = [msg](size_t at) { return static_cast<uint16_t>(msg[at] << 8 | msg[at + 1]); };
+    const uint16_t sequence = u16(1);
+    const uint16_t base = u16(3);
+    const uint16_t manufacturer = u16(5);
+    const uint32_t id = static_cast<uint32_t>(u16(7)) << 16 | u16(9);
+    const size_t size = u16(12);
+    const uint8_t *body = msg + HEADER_SIZE;
+    const size_t body_len = len - HEADER_SIZE;
+    Meter &meter = this->meters_[static_cast<uint64_t>(manufacturer) << 32 | id];
+
+    if (msg[0] == 'K') {
+      if (body_len != size)
+        return Result::MALFORMED;
+      meter.data.assign(body, body + body_len);
+    } else {
+      if (!meter.valid || meter.sequence != base) {
+        meter.valid = false;
+        return Result::MISSING_BASE;
+      }
+      std::vector<uint8_t> frame(size, 0);
+      for (size_t k = 0; k < size && k < meter.data.size(); k++)
+        frame[k] = meter.data[k];
+      size_t pos = 0;
+      size_t i = 0;
+      while (i < body_len) {
+        const uint8_t token = body[i++];
+        const size_t run = (token & 0x7F) + 1;
+        if (pos + run > size)
+          return Result::MALFORMED;
+        if (token & 0x80) {
+          if (i + run > body_len)
+            return Result::MALFORMED;
+          for (size_t k = 0; k < run; k++)
+            frame[pos + k] ^= body[i + k];
+          i += run;
+        }
+        pos += run;
+      }
+      meter.data.swap(frame);
+    }
+
+    meter.valid = true;
+    meter.sequence = sequence;
+    out.manufacturer = manufacturer;
+    out.id = id;
+    out.sequence = sequence;
+    out.rssi = static_cast<int8_t>(msg[11]);
+    out.keyframe = msg[0] == 'K';
+    out.data = meter.data;
+    return Result::OK;
+  }
+
+  Result apply(const std::vector<uint8_t> &msg, Frame &out) { return this->apply(msg.data(), msg.size(), out); }
+
+  // Forget all meters (e.g. after reconnecting to the broker)
+  void clear() { this->meters_.clear(); }
+
+private:
+  struct Meter {
+    bool valid{false};
+    uint16_t sequence{0};
+    std::vector<uint8_t> data;
+  };
+
+  std::unordered_map<uint64_t, Meter> meters_;
+};
+
+}  // namespace wmbus_bridge
@@ -0,0 +1,249 @@
+#pragma once
+
+// Decoder for the telegram payloads published by the wmbus_radio component
+// with `telegram_format: binary` or `telegram_format: cbor`. Header-only,
+// C++17, no dependencies: copy it into the consumer or add host/include to
+// its include path. The formats are described in docs/PAYLOAD_FORMATS.md.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace wmbus_bridge {
+
+enum class LinkMode : uint8_t { UNKNOWN = 0, T1 = 1, C1 = 2 };
+
+struct Telegram {
+  uint8_t version{0};
+  LinkMode link_mode{LinkMode::UNKNOWN};
+  char format{0};  // 'A', 'B' or 0
+  int8_t rssi{0};
+  // Unix time in ms if wall_clock, otherwise ms since the bridge booted
+  bool wall_clock{false};
+  uint64_t timestamp_ms{0};
+  uint32_t sequence{0};
+  // Frame bytes with DLL CRCs removed, starting with the L-field
+  std::vector<uint8_t> data;
+};
+
+static constexpr uint8_t ENVELOPE_VERSION = 1;
+static constexpr size_t BINARY_HEADER_SIZE = 20;
+static constexpr uint8_t BINARY_FLAG_WALL_CLOCK = 0x01;
+
+namespace detail {
+
+inline uint64_t get_be(const uint8_t *in, size_t bytes) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < bytes; i++)
+    value = (value << 8) | in[i];
+  return value;
+}
+
+// Bounds-checked reader for the subset of CBOR the bridge emits
+class CborReader {
+public:
+  CborReader(const uint8_t *data, size_t len) : pos_(data), end_(data + len) {}
+
+  bool ok() const { return this->ok_; }
+  bool at_end() const { return this->pos_ == this->end_; }
+
+  // Reads an item head; `major` gets the major type, `value` the argument
+  // (length, count or integer). Simple values (major 7) are returned as-is.
+  bool head(uint8_t &major, uint64_t &value) {
+    if (!this->need(1))
+      return false;
+    const uint8_t initial = *this->pos_++;
+    major = initial >> 5;
+    const uint8_t info = initial & 0x1F;
+    if (info < 24) {
+      value = info;
+      return true;
+    }
+    if (info > 27)  // indefinite lengths are never emitted
+      return this->fail();
+    const size_t bytes = size_t(1) << (info - 24);
+    if (!this->need(bytes))
+      return false;
+    value = get_be(this->pos_, bytes);
+    this->pos_ += bytes;
+    return true;
+  }
+
+  bool bytes(uint64_t len, const uint8_t *&out) {
+    if (!this->need(len))
+      return false;
+    out = this->pos_;
+    this->pos_ += len;
+    return true;
+  }
+
+  // Skips one complete item (used for keys added by future versions)
+  bool skip(int depth = 0) {
+    uint8_t major;
+    uint64_t value;
+    if (depth > 8 || !this->head(major, value))
+      return this->fail();
+    const uint8_t *unused;
+    switch (major) {
+      case 2:
+      case 3:
+        return this->bytes(value, unused);
+      case 4:
+        for (uint64_t i = 0; i < value; i++)
+          if (!this->skip(depth + 1))
+            return false;
+        return true;
+      case 5:
+        for (uint64_t i = 0; i < 2 * value; i++)
+          if (!this->skip(depth + 1))
+            return false;
+        return true;
+      case 6:
+        return this->skip(depth + 1);
+      default:
+        return true;
+    }
+  }
+
+private:
+  bool need(uint64_t n) {
+    if (!this->ok_ || n > uint64_t(this->end_ - this->pos_))
+      return this->fail();
+    return true;
+  }
+  bool fail() {
+    this->ok_ = false;
+    return false;
+  }
+
+  const uint8_t *pos_;
+  const uint8_t *end_;
+  bool ok_{true};
+};
+
+inline LinkMode link_mode_from_name(const uint8_t *name, size_t len) {
+  if (len == 2 && name[0] == 'T' && name[1] == '1')
+    return LinkMode::T1;
+  if (len == 2 && name[0] == 'C' && name[1] == '1')
+    return LinkMode::C1;
+  return LinkMode::UNKNOWN;
+}
+
+}  // namespace detail
+
+// Decodes a binary envelope. Returns false if the buffer is not a complete
+// envelope of a supported version. A header longer than 20 bytes is accepted
+// and the extra bytes skipped, so fields can be appended without a new version.
+inline bool decode_binary(const uint8_t *buf, size_t len, Telegram &out) {
+  if (len < BINARY_HEADER_SIZE || buf[0] != ENVELOPE_VERSION)
+    return false;
+  const size_t header_len = buf[1];
+  if (header_len < BINARY_HEADER_SIZE || header_len > len)
+    return false;
+  const size_t payload_len = detail::get_be(buf + 6, 2);
+  if (payload_len != len - header_len)
+    return false;
+
+  out.version = buf[0];
+  out.link_mode = static_cast<LinkMode>(buf[2]);
+  out.format = static_cast<char>(buf[3]);
+  out.rssi = static_cast<int8_t>(buf[4]);
+  out.wall_clock = (buf[5] & BINARY_FLAG_WALL_CLOCK) != 0;
+  out.sequence = static_cast<uint32_t>(detail::get_be(buf + 8, 4));
+  out.timestamp_ms = detail::get_be(buf + 12, 8);
+  out.data.assign(buf + header_len, buf + len);
+  return true;
+}
+
+// Decodes the CBOR variant. Unknown keys are ignored; "v" and "data" are
+// required.
+inline bool decode_cbor(const uint8_t *buf, size_t len, Telegram &out) {
+  detail::CborReader reader(buf, len);
+  uint8_t major;
+  uint64_t count;
+  if (!reader.head(major, count) || major != 5)
+    return false;
+
+  Telegram result;
+  bool have_data = false;
+  for (uint64_t i = 0; i < count; i++) {
+    uint64_t key_len;
+    const uint8_t *key;
+    if (!reader.head(major, key_len) || major != 3 || !reader.bytes(key_len, key))
+      return false;
+    const std::string name(reinterpret_cast<const char *>(key), key_len);
+
+    uint64_t value;
+    const uint8_t *bytes;
+    if (name == "data" || name == "mode" || name == "fmt") {
+      if (!reader.head(major, value) || (major != 2 && major != 3) || !reader.bytes(value, bytes))
+        return false;
+      if (name == "data") {
+        result.data.assign(bytes, bytes + value);
+        have_data = true;
+      } else if (name == "mode") {
+        result.link_mode = detail::link_mode_from_name(bytes, value);
+      } else {
+        result.format = value > 0 ? static_cast<char>(bytes[0]) : 0;
+      }
+    } else if (name == "v" || name == "seq" || name == "ts" || name == "rssi" || name == "wall") {
+      if (!reader.head(major, value))
+        return false;
+      if (name == "wall") {
+        if (major != 7)
+          return false;
+        result.wall_clock = value == 21;  // true
+      } else if (name == "rssi") {
+        if (major != 0 && major != 1)
+          return false;
+        result.rssi = static_cast<int8_t>(major == 0 ? static_cast<int64_t>(value)
+                                                     : -1 - static_cast<int64_t>(value));
+      } else if (major != 0) {
+        return false;
+      } else if (name == "v") {
+        result.version = static_cast<uint8_t>(value);
+      } else if (name == "seq") {
+        result.sequence = static_cast<uint32_t>(value);
+      } else {
+        result.timestamp_ms = value;
+      }
+    } else if (!reader.skip()) {
+      return false;
+    }
+  }
+
+  if (!reader.ok() || !reader.at_end() || !have_data || result.version != ENVELOPE_VERSION)
+    return false;
+  out = std::move(result);
+  return true;
+}
+
+// Splits a batch published with `telegram_batch` in binary or cbor format and
+// calls `fn(item, item_len)` for every item, in order. Returns false if the
+// batch is malformed; the items before the error have been delivered.
+template<typename F> bool for_each_batch_item(const uint8_t *buf, size_t len, F &&fn) {
+  size_t pos = 0;
+  while (pos < len) {
+    if (len - pos < 2)
+      return false;
+    const size_t item_len = static_cast<size_t>(detail::get_be(buf + pos, 2));
+    pos += 2;
+    if (item_len > len - pos)
+      return false;
+    fn(buf + pos, item_len);
+    pos += item_len;
+  }
+  return true;
+}
+
+inline bool decode_binary(const std::vector<uint8_t> &buf, Telegram &out) {
+  return decode_binary(buf.data(), buf.size(), out);
+}
+inline bool decode_cbor(const std::vector<uint8_t> &buf, Telegram &out) {
+  return decode_cbor(buf.data(), buf.size(), out);
+}
+
+}  // namespace wmbus_bridge
@@ -0,0 +1,527 @@
+// End-to-end load test of Radio on a host: a simulated transceiver feeds
+// the receiver task, loop() runs like ESPHome's main loop, and the run
+// reports loss, latency and CPU per frame.
+//
+//   wmbus_sim [options]
+//
+// Traffic (see SimOptions):
+//   --duration S          length of the run (10)
+//   --rate N              transmissions per second (100, 10x a busy site)
+//   --burst N[:GAP_US]    N transmissions back to back, GAP_US apart (1)
+//   --poisson             random (exponential) gaps between bursts
+//   --bitrate N           chips per second on air, 0 for no air time (100000)
+//   --ber P               bit error rate (0)
+//   --noise P             share of transmissions that are noise (0)
+//   --input FILE          frames from a capture (see capture.h), in a loop,
+//                         instead of synthetic ones:
+//   --mode t1|c1|mix      link mode (mix)
+//   --size MIN:MAX        frame size without CRCs, L-field + 1 (40:100; T1
+//                         frames under 38 bytes are rejected as too short)
+//   --meters N            distinct meter IDs (200)
+//   --seed N              random seed (1)
+// Radio (as in the YAML options of the same names):
+//   --queue-depth N, --queue-overflow drop_newest|drop_oldest|drop_lowest_rssi,
+//   --processing-task, --telegram-topic TOPIC, --telegram-format hex|rtlwmbus|binary|cbor,
+//   --publish-queue N (telegrams), --dedup WINDOW_MS, --no-diagnostic-verbose
+// Environment:
+//   --loop-interval MS    time between two loop() calls (16, ESPHome's default)
+//   --stall MS:EVERY_MS   block the main loop for MS every EVERY_MS
+//   --handler-us N        CPU time an on_frame handler takes (0)
+//   --publish-us N        time an MQTT publish blocks (0)
+//
+// Latency is measured from the end of a frame on air to its on_frame
+// handler. CPU per frame is the CPU time of the receiver task, the
+// processing task and loop(), divided by the packets the radio received.
+
+#include <time.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "esp_timer.h"
+#include "esphome/components/mqtt/mqtt_client.h"
+#include "freertos/task.h"
+
+#include "component.h"
+#include "packet.h"
+
+#include "capture.h"
+#include "frame_builder.h"
+#include "sim_transceiver.h"
+
+using namespace esphome::wmbus_radio;
+using namespace wmbus_host;
+
+namespace {
+
+// Exposes the counters Radio keeps for its diagnostic summary
+class SimRadio : public Radio {
+public:
+  TaskHandle_t receiver_task() const { return this->receiver_task_handle_; }
+  TaskHandle_t processing_task() const { return this->processing_task_handle_; }
+  uint32_t dropped(DropReason reason) const { return this->diag_dropped_by_reason_[(size_t) reason]; }
+  uint32_t dropped() const { return this->diag_dropped_; }
+  uint32_t truncated() const { return this->diag_truncated_; }
+  uint32_t duplicates() const { return this->dedup_duplicates_; }
+  uint32_t queue_high_water() const { return this->queue_high_water_.load(); }
+  uint32_t queue_evictions() const { return this->queue_evictions_.load(); }
+  uint32_t queue_wait_count() const { return this->queue_wait_count_; }
+  uint64_t queue_wait_total_us() const { return this->queue_wait_total_us_; }
+  uint32_t queue_wait_max_us() const { return this->queue_wait_max_us_; }
+  uint32_t published() const { return this->publisher_.published(); }
+  uint32_t publish_failed() const { return this->publisher_.failed(); }
+  size_t queued() const { return this->packet_pool_.queued() + this->packet_pool_.processed_queued(); }
+};
+
+struct Options {
+  SimOptions sim;
+  const char *input{nullptr};
+  const char *mode{"mix"};
+  size_t min_size{40};
+  size_t max_size{100};
+  uint32_t meters{200};
+
+  uint8_t queue_depth{8};
+  PacketPool::OverflowPolicy queue_overflow{PacketPool::OVERFLOW_DROP_NEWEST};
+  bool processing_task{false};
+  std::string telegram_topic;
+  Frame::OutputFormat telegram_format{Frame::FORMAT_HEX};
+  size_t publish_queue{0};
+  uint32_t dedup_window_ms{0};
+  bool diag_verbose{true};
+
+  uint32_t loop_interval_ms{16};
+  uint32_t stall_ms{0};
+  uint32_t stall_every_ms{0};
+  uint32_t handler_us{0};
+  uint32_t publish_us{0};
+};
+
+// Key of the frame the radio should decode from `raw` (0 if it does not)
+uint32_t frame_key(const std::vector<uint8_t> &raw) {
+  thread_local Packet packet;
+  packet.reset();
+  const size_t len = std::min(raw.size(), PACKET_CAPACITY);
+  std::memcpy(packet.append_space(len), raw.data(), len);
+  auto frame = packet.convert_to_frame();
+  if (!frame)
+    return 0;
+  return std::max<uint32_t>(fnv1a(frame->data(), frame->size()), 1);
+}
+
+uint64_t thread_cpu_ns() {
+  timespec ts{};
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+void busy_wait_us(uint32_t us) {
+  const int64_t until = esp_timer_get_time() + us;
+  while (esp_timer_get_time() < until) {
+  }
+}
+
+// Synthetic frames: random meter, mode, format and size, all different
+class SyntheticSource {
+public:
+  explicit SyntheticSource(const Options &options) : options_(options), random_(options.sim.seed + 1) {}
+
+  SimFrame operator()() {
+    std::uniform_int_distribution<size_t> size(this->options_.min_size, this->options_.max_size);
+    std::uniform_int_distribution<uint32_t> meter(0, this->options_.meters - 1);
+    std::uniform_int_distribution<int> variant(0, 3);
+    const uint32_t number = this->number_++;
+    const uint32_t id = meter(this->random_);
+
+    const auto frame = make_meter_frame(size(this->random_), id, number);
+
+    // T1 and C1 in format A and B
+    int which = variant(this->random_);
+    if (std::strcmp(this->options_.mode, "t1") == 0)
+      which &= 1;
+    else if (std::strcmp(this->options_.mode, "c1") == 0)
+      which |= 2;
+    SimFrame out;
+    out.raw = encode_packet(frame, which & 2 ? LinkMode::C1 : LinkMode::T1,
+                            which & 1 ? FrameFormat::B : FrameFormat::A);
+    out.rssi = (int8_t) (-60 - (int) (id % 40));
+    out.key = frame_key(out.raw);
+    return out;
+  }
+
+protected:
+  const Options &options_;
+  std::mt19937 random_;
+  uint32_t number_{0};
+};
+
+bool load_capture(const char *path, std::vector<SimFrame> &frames) {
+  std::ifstream in(path);
+  if (!in)
+    return false;
+  std::string line;
+  std::vector<uint8_t> raw;
+  int rssi;
+  while (std::getline(in, line)) {
+    if (parse_capture_line(line, raw, rssi) == CaptureLine::NONE)
+      continue;
+    SimFrame frame;
+    frame.raw = raw;
+    frame.rssi = (int8_t) (rssi != 0 ? rssi : -80);
+    frame.key = frame_key(raw);
+    frames.push_back(std::move(frame));
+  }
+  return true;
+}
+
+// Frames received by the radio and not yet handled, by key
+class InFlight {
+public:
+  void add(uint32_t key, int64_t end_us) {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->frames_.emplace(key, end_us);
+  }
+  // Time the frame ended on air, or -1 if it is not in flight
+  int64_t take(uint32_t key) {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    // A capture played in a loop repeats its frames: take the latest copy,
+    // earlier ones were dropped (e.g. as duplicates) if they are still here
+    auto range = this->frames_.equal_range(key);
+    if (range.first == range.second)
+      return -1;
+    auto latest = range.first;
+    for (auto it = range.first; it != range.second; ++it)
+      if (it->second > latest->second)
+        latest = it;
+    const int64_t end_us = latest->second;
+    this->frames_.erase(latest);
+    return end_us;
+  }
+  size_t size() {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    return this->frames_.size();
+  }
+
+protected:
+  std::mutex mutex_;
+  std::unordered_multimap<uint32_t, int64_t> frames_;
+};
+
+bool parse_pair(const char *text, uint32_t &first, uint32_t &second) {
+  char *end;
+  first = std::strtoul(text, &end, 10);
+  if (*end != ':')
+    return false;
+  second = std::strtoul(end + 1, &end, 10);
+  return *end == '\0';
+}
+
+int usage(const char *name) {
+  std::fprintf(stderr,
+               "Usage: %s [--duration S] [--rate N] [--burst N[:GAP_US]] [--poisson] [--bitrate N] [--ber P]\n"
+               "       [--noise P] [--input FILE | --mode t1|c1|mix --size MIN:MAX --meters N] [--seed N]\n"
+               "       [--queue-depth N] [--queue-overflow POLICY] [--processing-task] [--telegram-topic TOPIC]\n"
+               "       [--telegram-format FORMAT] [--publish-queue N] [--dedup WINDOW_MS] [--no-diagnostic-verbose]\n"
+               "       [--loop-interval MS] [--stall MS:EVERY_MS] [--handler-us N] [--publish-us N]\n",
+               name);
+  return 2;
+}
+
+bool parse_options(int argc, char **argv, Options &options) {
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+    uint32_t first, second;
+    if (std::strcmp(arg, "--poisson") == 0) {
+      options.sim.poisson = true;
+      continue;
+    }
+    if (std::strcmp(arg, "--processing-task") == 0) {
+      options.processing_task = true;
+      continue;
+    }
+    if (std::strcmp(arg, "--no-diagnostic-verbose") == 0) {
+      options.diag_verbose = false;
+      continue;
+    }
+    if (value == nullptr)
+      return false;
+    i++;
+    if (std::strcmp(arg, "--duration") == 0) {
+      options.sim.duration_s = std::atof(value);
+    } else if (std::strcmp(arg, "--rate") == 0) {
+      options.sim.rate = std::atof(value);
+    } else if (std::strcmp(arg, "--burst") == 0) {
+      if (parse_pair(value, first, second)) {
+        options.sim.burst = first;
+        options.sim.burst_gap_us = second;
+      } else {
+        options.sim.burst = std::strtoul(value, nullptr, 10);
+      }
+    } else if (std::strcmp(arg, "--bitrate") == 0) {
+      options.sim.bitrate = std::strtoul(value, nullptr, 10);
+    } else if (std::strcmp(arg, "--ber") == 0) {
+      options.sim.ber = std::atof(value);
+    } else if (std::strcmp(arg, "--noise") == 0) {
+      options.sim.noise = std::atof(value);
+    } else if (std::strcmp(arg, "--seed") == 0) {
+      options.sim.seed = std::strtoul(value, nullptr, 10);
+    } else if (std::strcmp(arg, "--input") == 0) {
+      options.input = value;
+    } else if (std::strcmp(arg, "--mode") == 0) {
+      options.mode = value;
+      if (std::strcmp(value, "t1") != 0 && std::strcmp(value, "c1") != 0 && std::strcmp(value, "mix") != 0)
+        return false;
+    } else if (std::strcmp(arg, "--size") == 0) {
+      if (!parse_pair(value, first, second) || first < 20 || second < first || second > 256)
+        return false;
+      options.min_size = first;
+      options.max_size = second;
+    } else if (std::strcmp(arg, "--meters") == 0) {
+      options.meters = std::max<uint32_t>(std::strtoul(value, nullptr, 10), 1);
+    } else if (std::strcmp(arg, "--queue-depth") == 0) {
+      options.queue_depth = (uint8_t) std::clamp<unsigned long>(std::strtoul(value, nullptr, 10), 2, 64);
+    } else if (std::strcmp(arg, "--queue-overflow") == 0) {
+      if (std::strcmp(value, "drop_newest") == 0)
+        options.queue_overflow = PacketPool::OVERFLOW_DROP_NEWEST;
+      else if (std::strcmp(value, "drop_oldest") == 0)
+        options.queue_overflow = PacketPool::OVERFLOW_DROP_OLDEST;
+      else if (std::strcmp(value, "drop_lowest_rssi") == 0)
+        options.queue_overflow = PacketPool::OVERFLOW_DROP_LOWEST_RSSI;
+      else
+        return false;
+    } else if (std::strcmp(arg, "--telegram-topic") == 0) {
+      options.telegram_topic = value;
+    } else if (std::strcmp(arg, "--telegram-format") == 0) {
+      if (std::strcmp(value, "hex") == 0)
+        options.telegram_format = Frame::FORMAT_HEX;
+      else if (std::strcmp(value, "rtlwmbus") == 0)
+        options.telegram_format = Frame::FORMAT_RTLWMBUS;
+      else if (std::strcmp(value, "binary") == 0)
+        options.telegram_format = Frame::FORMAT_BINARY;
+      else if (std::strcmp(value, "cbor") == 0)
+        options.telegram_format = Frame::FORMAT_CBOR;
+      else
+        return false;
+    } else if (std::strcmp(arg, "--publish-queue") == 0) {
+      options.publish_queue = std::strtoul(value, nullptr, 10);
+    } else if (std::strcmp(arg, "--dedup") == 0) {
+      options.dedup_window_ms = std::strtoul(value, nullptr, 10);
+    } else if (std::strcmp(arg, "--loop-interval") == 0) {
+      options.loop_interval_ms = std::strtoul(value, nullptr, 10);
+    } else if (std::strcmp(arg, "--stall") == 0) {
+      if (!parse_pair(value, options.stall_ms, options.stall_every_ms) || options.stall_every_ms == 0)
+        return false;
+    } else if (std::strcmp(arg, "--handler-us") == 0) {
+      options.handler_us = std::strtoul(value, nullptr, 10);
+    } else if (std::strcmp(arg, "--publish-us") == 0) {
+      options.publish_us = std::strtoul(value, nullptr, 10);
+    } else {
+      return false;
+    }
+  }
+  return options.sim.rate > 0 && options.sim.duration_s > 0;
+}
+
+double percentile_ms(const std::vector<uint32_t> &sorted_us, double p) {
+  if (sorted_us.empty())
+    return 0;
+  return sorted_us[std::min(sorted_us.size() - 1, (size_t) (p * sorted_us.size()))] / 1000.0;
+}
+
+double share(uint64_t part, uint64_t whole) { return whole ? 100.0 * part / whole : 0.0; }
+
+} // namespace
+
+int main(int argc, char **argv) {
+  Options options;
+  if (!parse_options(argc, argv, options))
+    return usage(argv[0]);
+
+  SimTransceiver transceiver(options.sim);
+  std::vector<SimFrame> capture;
+  SyntheticSource synthetic(options);
+  if (options.input != nullptr) {
+    if (!load_capture(options.input, capture) || capture.empty()) {
+      std::fprintf(stderr, "No packets in %s\n", options.input);
+      return 2;
+    }
+    size_t next = 0;
+    transceiver.set_source([&capture, next]() mutable { return capture[next++ % capture.size()]; });
+  } else {
+    transceiver.set_source([&synthetic] { return synthetic(); });
+  }
+
+  InFlight in_flight;
+  uint64_t intact = 0;
+  transceiver.set_on_received([&](const SimFrame &frame, int64_t end_us) {
+    intact++;
+    in_flight.add(frame.key, end_us);
+  });
+
+  // Counts what would go to the broker
+  esphome::mqtt::MQTTClientComponent mqtt;
+  esphome::mqtt::global_mqtt_client = &mqtt;
+  uint64_t telegram_messages = 0, telegram_bytes = 0, other_messages = 0;
+  mqtt.on_publish = [&](const std::string &topic, const char *payload, size_t length) {
+    const auto &prefix = options.telegram_topic;
+    if (!prefix.empty() && topic.compare(0, prefix.size(), prefix) == 0) {
+      telegram_messages++;
+      telegram_bytes += length;
+    } else {
+      other_messages++;
+    }
+    if (options.publish_us)
+      std::this_thread::sleep_for(std::chrono::microseconds(options.publish_us));
+    return true;
+  };
+
+  SimRadio radio;
+  radio.set_radio(&transceiver);
+  radio.set_queue_depth(options.queue_depth);
+  radio.set_queue_overflow(options.queue_overflow);
+  if (options.processing_task)
+    radio.set_processing_task(-1, 2, 3 * 1024);
+  if (!options.telegram_topic.empty()) {
+    radio.set_telegram_topic(options.telegram_topic);
+    radio.set_telegram_format(options.telegram_format);
+  }
+  if (options.publish_queue > 0)
+    radio.set_publish_queue(options.publish_queue, 4, 5000);
+  DedupCache dedup(128, options.dedup_window_ms);
+  if (options.dedup_window_ms > 0)
+    radio.set_dedup_cache(&dedup);
+  radio.set_diag_verbose(options.diag_verbose);
+  // Counters are read at the end: no summary may reset them
+  radio.set_diag_summary_interval_ms(UINT32_MAX);
+
+  std::vector<uint32_t> latencies_us;
+  uint64_t unexpected = 0;
+  radio.add_frame_handler([&](Frame *frame) {
+    const int64_t end_us = in_flight.take(fnv1a(frame->data(), frame->size()));
+    if (end_us < 0)
+      unexpected++;
+    else
+      latencies_us.push_back((uint32_t) (esp_timer_get_time() - end_us));
+    if (options.handler_us)
+      busy_wait_us(options.handler_us);
+  });
+
+  transceiver.setup();
+  radio.setup();
+  if (radio.is_failed()) {
+    std::fprintf(stderr, "Radio setup failed\n");
+    return 1;
+  }
+  transceiver.start();
+
+  // ESPHome's main loop: loop(), then sleep for the rest of the interval
+  std::atomic<bool> generating{true};
+  std::thread waiter([&] {
+    transceiver.join();
+    generating = false;
+  });
+  const int64_t start_us = esp_timer_get_time();
+  int64_t next_stall_us = start_us + (int64_t) options.stall_every_ms * 1000;
+  int64_t drain_until_us = 0;
+  uint64_t loops = 0, loop_cpu_ns = 0, loop_total_us = 0, loop_max_us = 0;
+  while (true) {
+    const int64_t loop_start_us = esp_timer_get_time();
+    if (!generating) {
+      if (drain_until_us == 0)
+        drain_until_us = loop_start_us + 2000000;
+      // Done once the queue is empty (or does not empty)
+      if (radio.queued() == 0 || loop_start_us > drain_until_us)
+        break;
+    }
+    const uint64_t cpu_before = thread_cpu_ns();
+    radio.loop();
+    loop_cpu_ns += thread_cpu_ns() - cpu_before;
+    const uint64_t elapsed_us = esp_timer_get_time() - loop_start_us;
+    loops++;
+    loop_total_us += elapsed_us;
+    loop_max_us = std::max(loop_max_us, elapsed_us);
+
+    if (options.stall_ms && loop_start_us >= next_stall_us) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(options.stall_ms));
+      next_stall_us += (int64_t) options.stall_every_ms * 1000;
+    }
+    std::this_thread::sleep_until(std::chrono::steady_clock::time_point(
+        std::chrono::microseconds(loop_start_us + (int64_t) options.loop_interval_ms * 1000)));
+  }
+  waiter.join();
+  const double seconds = (esp_timer_get_time() - start_us) / 1e6;
+
+  const auto sim = transceiver.stats();
+  std::printf("Air:      %llu transmissions in %.1f s (%.0f/s), %llu not decodable, %llu with bit errors, "
+              "channel busy %.1f%%\n",
+              (unsigned long long) sim.sent, options.sim.duration_s, sim.sent / options.sim.duration_s,
+              (unsigned long long) sim.undecodable, (unsigned long long) sim.corrupted,
+              share(sim.air_us, (uint64_t) (options.sim.duration_s * 1e6)));
+  std::printf("Radio:    %llu received, %llu missed while not listening (%.2f%%), %llu rx restarts\n",
+              (unsigned long long) sim.received, (unsigned long long) sim.missed, share(sim.missed, sim.sent),
+              (unsigned long long) sim.restarts);
+
+  // Duplicates are dropped on purpose
+  const uint64_t handled = latencies_us.size();
+  const uint64_t lost = intact - std::min<uint64_t>(intact, handled + radio.duplicates());
+  std::printf("Frames:   %llu intact received, %llu handled, %llu lost (%.2f%%)", (unsigned long long) intact,
+              (unsigned long long) handled, (unsigned long long) lost, share(lost, intact));
+  if (unexpected)
+    std::printf(", %llu unexpected", (unsigned long long) unexpected);
+  std::printf("\n");
+  std::printf("Dropped:  %u packets", (unsigned) radio.dropped());
+  for (size_t i = 1; i < (size_t) DropReason::COUNT; i++) {
+    const auto reason = (DropReason) i;
+    if (reason != DropReason::TRUNCATED && radio.dropped(reason))
+      std::printf(", %s %u", drop_reason_name(reason), (unsigned) radio.dropped(reason));
+  }
+  std::printf(", truncated %u", (unsigned) radio.truncated());
+  if (options.dedup_window_ms)
+    std::printf(", duplicate %u", (unsigned) radio.duplicates());
+  std::printf("\n");
+
+  std::sort(latencies_us.begin(), latencies_us.end());
+  uint64_t latency_total_us = 0;
+  for (uint32_t us : latencies_us)
+    latency_total_us += us;
+  std::printf("Latency:  avg %.2f ms, p50 %.2f ms, p99 %.2f ms, max %.2f ms (end of frame to on_frame)\n",
+              handled ? latency_total_us / 1000.0 / handled : 0.0, percentile_ms(latencies_us, 0.5),
+              percentile_ms(latencies_us, 0.99), latencies_us.empty() ? 0.0 : latencies_us.back() / 1000.0);
+  std::printf("Queue:    depth %u, high water %u, evicted %u, wait avg %.2f ms, max %.2f ms\n",
+              (unsigned) options.queue_depth, (unsigned) radio.queue_high_water(),
+              (unsigned) radio.queue_evictions(),
+              radio.queue_wait_count() ? radio.queue_wait_total_us() / 1000.0 / radio.queue_wait_count() : 0.0,
+              radio.queue_wait_max_us() / 1000.0);
+
+  const uint64_t receiver_ns = host_task_cpu_ns(radio.receiver_task());
+  const uint64_t processing_ns = host_task_cpu_ns(radio.processing_task());
+  const double per_frame = sim.received ? 1000.0 * sim.received : 1.0;
+  std::printf("CPU:      %.2f us per received packet (receiver %.2f, processing %.2f, loop %.2f)\n",
+              (receiver_ns + processing_ns + loop_cpu_ns) / per_frame, receiver_ns / per_frame,
+              processing_ns / per_frame, loop_cpu_ns / per_frame);
+  std::printf("loop():   %llu calls in %.1f s, avg %.1f us, max %.1f ms\n", (unsigned long long) loops, seconds,
+              loops ? (double) loop_total_us / loops : 0.0, loop_max_us / 1000.0);
+  if (!options.telegram_topic.empty())
+    std::printf("MQTT:     %llu telegram messages (%llu bytes), %u published, %u failed, %llu other messages\n",
+                (unsigned long long) telegram_messages, (unsigned long long) telegram_bytes,
+                (unsigned) radio.published(), (unsigned) radio.publish_failed(),
+                (unsigned long long) other_messages);
+  else
+    std::printf("MQTT:     %llu diagnostic messages\n", (unsigned long long) other_messages);
+
+  // The radio tasks never return
+  std::fflush(stdout);
+  std::quick_exit(0);
+}
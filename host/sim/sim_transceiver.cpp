@@ -0,0 +1,129 @@
+#include "sim_transceiver.h"
+
+#include <time.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include "esp_timer.h"
+#include "frame_encoder.h"
+
+namespace wmbus_host {
+
+void SimIrqPin::raise() {
+  this->level_ = true;
+  if (this->func_ != nullptr)
+    this->func_(this->arg_);
+}
+
+SimTransceiver::SimTransceiver(const SimOptions &options)
+    : options_(options), random_(options.seed), bit_error_state_(options.seed) {
+  this->irq_pin_ = &this->irq_;
+  this->reset_pin_ = nullptr;
+}
+
+void SimTransceiver::restart_rx() {
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  this->irq_.clear();
+  this->rx_.clear();
+  this->rx_pos_ = 0;
+  this->listening_ = true;
+  this->listening_since_us_ = esp_timer_get_time();
+  this->stats_.restarts++;
+}
+
+int8_t SimTransceiver::get_rssi() {
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  return this->rx_rssi_;
+}
+
+esphome::optional<uint8_t> SimTransceiver::read() {
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  if (this->rx_pos_ >= this->rx_.size())
+    return {};
+  return this->rx_[this->rx_pos_++];
+}
+
+void SimTransceiver::start() { this->thread_ = std::thread(&SimTransceiver::run_, this); }
+
+void SimTransceiver::join() {
+  if (this->thread_.joinable())
+    this->thread_.join();
+}
+
+SimTransceiver::Stats SimTransceiver::stats() {
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  return this->stats_;
+}
+
+void SimTransceiver::transmit_(SimFrame &frame, int64_t start_us, int64_t end_us) {
+  const bool corrupted =
+      esphome::wmbus_radio::inject_bit_errors(frame.raw.data(), frame.raw.size(), this->options_.ber,
+                                              this->bit_error_state_) > 0;
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->stats_.sent++;
+    if (frame.key == 0)
+      this->stats_.undecodable++;
+    if (corrupted)
+      this->stats_.corrupted++;
+    this->stats_.air_us += end_us - start_us;
+    // Deaf since the last packet, or restarted while this one was on air
+    if (!this->listening_ || this->listening_since_us_ > start_us) {
+      this->stats_.missed++;
+      return;
+    }
+    this->listening_ = false;
+    this->rx_ = frame.raw;
+    this->rx_pos_ = 0;
+    this->rx_rssi_ = frame.rssi;
+    this->stats_.received++;
+  }
+  if (!corrupted && frame.key != 0 && this->on_received_)
+    this->on_received_(frame, end_us);
+  this->irq_.raise();
+}
+
+void SimTransceiver::run_() {
+  using clock = std::chrono::steady_clock;
+  const auto &options = this->options_;
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  std::uniform_int_distribution<int> byte(0, 255);
+  std::uniform_int_distribution<size_t> noise_size(12, 64);
+  const double burst_interval_us = 1e6 * std::max<uint32_t>(options.burst, 1) / options.rate;
+  std::exponential_distribution<double> poisson_gap(1.0 / burst_interval_us);
+
+  // esp_timer and steady_clock share their epoch on the host
+  const int64_t begin_us = esp_timer_get_time();
+  const int64_t end_us = begin_us + (int64_t) (options.duration_s * 1e6);
+  int64_t burst_start_us = begin_us;
+  int64_t channel_free_us = begin_us;
+  // Transmissions wait for the channel: more than it can carry is not sent
+  while (std::max(burst_start_us, channel_free_us) < end_us) {
+    int64_t start_us = std::max(burst_start_us, channel_free_us);
+    for (uint32_t i = 0; i < std::max<uint32_t>(options.burst, 1) && start_us < end_us; i++) {
+      SimFrame frame;
+      if (options.noise > 0 && uniform(this->random_) < options.noise) {
+        frame.raw.resize(noise_size(this->random_));
+        for (auto &b : frame.raw)
+          b = (uint8_t) byte(this->random_);
+        frame.rssi = -100;
+      } else {
+        frame = this->source_();
+      }
+      const int64_t air_us = options.bitrate ? (int64_t) (frame.raw.size() * 8e6 / options.bitrate) : 0;
+      const int64_t frame_end_us = start_us + air_us;
+      std::this_thread::sleep_until(clock::time_point(std::chrono::microseconds(frame_end_us)));
+      this->transmit_(frame, start_us, frame_end_us);
+      start_us = frame_end_us + options.burst_gap_us;
+    }
+    channel_free_us = start_us;
+    burst_start_us += (int64_t) (options.poisson ? poisson_gap(this->random_) : burst_interval_us);
+  }
+
+  timespec ts{};
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  this->generator_cpu_ns_ = (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+} // namespace wmbus_host
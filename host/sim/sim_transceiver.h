@@ -0,0 +1,117 @@
+#pragma once
+
+// A transceiver without hardware, for load tests of Radio on a host. A
+// generator thread puts frames "on air" at a configurable rate and hands
+// them over like the SX1262 does: the whole packet is buffered, then the
+// IRQ line rises, and the radio stays deaf until the next restart_rx().
+// A frame is therefore only received if the radio was listening when it
+// started, which is what limits a real receiver between two packets.
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "transceiver.h"
+
+namespace wmbus_host {
+
+// One transmission: on-air bytes as a transceiver delivers them
+struct SimFrame {
+  std::vector<uint8_t> raw;
+  int8_t rssi{-80};
+  // Identifies the decoded frame (0: the bytes are not expected to decode)
+  uint32_t key{0};
+};
+
+struct SimOptions {
+  double rate{100};         // transmissions per second, on average
+  uint32_t burst{1};        // transmissions back to back
+  uint32_t burst_gap_us{0}; // silence between two transmissions of a burst
+  bool poisson{false};      // exponential gaps between bursts instead of even spacing
+  uint32_t bitrate{100000}; // chips per second on air (T1 and C1); 0: no air time
+  double ber{0};            // bit error rate on air
+  double noise{0};          // share of transmissions that are noise
+  double duration_s{10};
+  uint32_t seed{1};
+};
+
+class SimIrqPin : public esphome::InternalGPIOPin {
+public:
+  bool digital_read() override { return this->level_; }
+  void attach_interrupt(void (*func)(void *), void *arg, esphome::gpio::InterruptType type) const override {
+    this->func_ = func;
+    this->arg_ = arg;
+  }
+  // Raise the line and run the interrupt handler (in the calling thread)
+  void raise();
+  void clear() { this->level_ = false; }
+
+protected:
+  std::atomic<bool> level_{false};
+  mutable void (*func_)(void *){nullptr};
+  mutable void *arg_{nullptr};
+};
+
+class SimTransceiver : public esphome::wmbus_radio::RadioTransceiver {
+public:
+  struct Stats {
+    uint64_t sent{0};
+    uint64_t undecodable{0};  // noise included
+    uint64_t corrupted{0};  // hit by bit errors
+    uint64_t missed{0};     // the radio was not listening
+    uint64_t received{0};   // buffered and signalled to the receiver task
+    uint64_t restarts{0};
+    uint64_t air_us{0};
+  };
+
+  explicit SimTransceiver(const SimOptions &options);
+
+  // Where the frames come from (called from the generator thread)
+  void set_source(std::function<SimFrame()> &&source) { this->source_ = std::move(source); }
+  // Called from the generator thread for every intact frame the radio
+  // receives, before the interrupt, with the time the frame ended on air
+  void set_on_received(std::function<void(const SimFrame &, int64_t end_us)> &&callback) {
+    this->on_received_ = std::move(callback);
+  }
+
+  void setup() override {}
+  void restart_rx() override;
+  int8_t get_rssi() override;
+  const char *get_name() override { return "Simulated"; }
+
+  void start();
+  // Waits for the generator to finish the run
+  void join();
+  // CPU time of the generator thread, not part of what is measured
+  uint64_t generator_cpu_ns() const { return this->generator_cpu_ns_; }
+  Stats stats();
+
+protected:
+  esphome::optional<uint8_t> read() override;
+
+  void run_();
+  void transmit_(SimFrame &frame, int64_t start_us, int64_t end_us);
+
+  SimOptions options_;
+  SimIrqPin irq_;
+  std::function<SimFrame()> source_;
+  std::function<void(const SimFrame &, int64_t)> on_received_;
+  std::thread thread_;
+  uint64_t generator_cpu_ns_{0};
+  std::mt19937 random_;
+  uint32_t bit_error_state_;
+
+  std::mutex mutex_;
+  Stats stats_;
+  bool listening_{false};
+  int64_t listening_since_us_{0};
+  std::vector<uint8_t> rx_;
+  size_t rx_pos_{0};
+  int8_t rx_rssi_{0};
+};
+
+} // namespace wmbus_host
@@ -0,0 +1,11 @@
+#pragma once
+
+// Host stand-in for ESP-IDF's esp_timer.h: microseconds of a monotonic clock
+
+#include <chrono>
+#include <cstdint>
+
+inline int64_t esp_timer_get_time() {
+  using namespace std::chrono;
+  return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
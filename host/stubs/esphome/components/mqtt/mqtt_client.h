@@ -0,0 +1,38 @@
+#pragma once
+
+// Host stand-in for ESPHome's MQTT client: nothing is sent, every message
+// goes to `on_publish` (if set), which decides whether publishing worked
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace esphome {
+namespace mqtt {
+
+using mqtt_callback_t = std::function<void(const std::string &, const std::string &)>;
+
+class MQTTClientComponent {
+public:
+  bool is_connected() { return this->connected; }
+
+  bool publish(const std::string &topic, const std::string &payload, uint8_t qos = 0, bool retain = false) {
+    return this->publish(topic, payload.data(), payload.size(), qos, retain);
+  }
+  bool publish(const std::string &topic, const char *payload, size_t payload_length, uint8_t qos = 0,
+               bool retain = false) {
+    if (!this->connected)
+      return false;
+    return !this->on_publish || this->on_publish(topic, payload, payload_length);
+  }
+  void subscribe(const std::string &topic, mqtt_callback_t callback, uint8_t qos = 0) {}
+
+  bool connected{true};
+  std::function<bool(const std::string &topic, const char *payload, size_t length)> on_publish;
+};
+
+inline MQTTClientComponent *global_mqtt_client = nullptr;
+
+} // namespace mqtt
+} // namespace esphome
@@ -0,0 +1,36 @@
+#pragma once
+
+// Host stand-in for ESPHome's SPI component: no bus, transfers read 0
+
+#include <cstdint>
+
+#include "esphome/core/component.h"
+#include "esphome/core/gpio.h"
+
+namespace esphome {
+namespace spi {
+
+enum BitOrder { BIT_ORDER_LSB_FIRST, BIT_ORDER_MSB_FIRST };
+enum ClockPolarity { CLOCK_POLARITY_LOW, CLOCK_POLARITY_HIGH };
+enum ClockPhase { CLOCK_PHASE_LEADING, CLOCK_PHASE_TRAILING };
+enum DataRate : uint32_t { DATA_RATE_1MHZ = 1000000, DATA_RATE_2MHZ = 2000000 };
+
+class SPIDelegate {
+public:
+  virtual ~SPIDelegate() = default;
+  virtual void begin_transaction() {}
+  virtual void end_transaction() {}
+  virtual uint8_t transfer(uint8_t data) { return 0; }
+};
+
+template<BitOrder BIT_ORDER, ClockPolarity CLOCK_POLARITY, ClockPhase CLOCK_PHASE, DataRate DATA_RATE>
+class SPIDevice {
+public:
+  void spi_setup() {}
+
+protected:
+  SPIDelegate *delegate_{nullptr};
+};
+
+} // namespace spi
+} // namespace esphome
@@ -0,0 +1,34 @@
+#pragma once
+
+// Host stand-in for ESPHome's gpio.h: pins do nothing unless a subclass
+// (e.g. a simulated transceiver's IRQ line) says otherwise
+
+#include <cstdint>
+
+namespace esphome {
+
+namespace gpio {
+enum InterruptType : uint8_t {
+  INTERRUPT_RISING_EDGE = 1,
+  INTERRUPT_FALLING_EDGE = 2,
+  INTERRUPT_ANY_EDGE = 3,
+};
+} // namespace gpio
+
+class GPIOPin {
+public:
+  virtual ~GPIOPin() = default;
+  virtual void setup() {}
+  virtual bool digital_read() { return false; }
+  virtual void digital_write(bool value) {}
+};
+
+class InternalGPIOPin : public GPIOPin {
+public:
+  template<typename T> void attach_interrupt(void (*func)(T *), T *arg, gpio::InterruptType type) const {
+    this->attach_interrupt(reinterpret_cast<void (*)(void *)>(func), arg, type);
+  }
+  virtual void attach_interrupt(void (*func)(void *), void *arg, gpio::InterruptType type) const {}
+};
+
+} // namespace esphome
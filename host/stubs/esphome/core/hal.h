@@ -0,0 +1,23 @@
+#pragma once
+
+// Host stand-in for ESPHome's hal.h
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+namespace esphome {
+
+inline uint32_t millis() {
+  using namespace std::chrono;
+  return (uint32_t) duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+inline uint32_t micros() {
+  using namespace std::chrono;
+  return (uint32_t) duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+inline void delay(uint32_t ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+
+} // namespace esphome
@@ -0,0 +1,31 @@
+#pragma once
+
+// Host stand-in for ESPHome's helpers.h: just what wmbus_radio uses.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "esphome/core/hal.h"
+
+namespace esphome {
+
+// Heap allocation; the flags (PSRAM or internal RAM) mean nothing on a host
+template<class T> class RAMAllocator {
+public:
+  enum Flags : uint8_t {
+    NONE = 0,
+    ALLOC_EXTERNAL = 1 << 0,
+    ALLOC_INTERNAL = 1 << 1,
+    ALLOW_FAILURE = 1 << 2,
+  };
+
+  RAMAllocator() = default;
+  RAMAllocator(uint8_t flags) {}
+
+  T *allocate(size_t n) { return static_cast<T *>(std::malloc(n * sizeof(T))); }
+  void deallocate(T *p, size_t n) { std::free(p); }
+};
+
+} // namespace esphome
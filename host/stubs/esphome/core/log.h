@@ -0,0 +1,15 @@
+#pragma once
+
+// Host stand-in for ESPHome's log.h. Errors and warnings go to stderr;
+// everything else is compiled out so it does not distort measurements.
+
+#include <cstdio>
+
+#define ESP_LOGE(tag, format, ...) std::fprintf(stderr, "[E][%s] " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) std::fprintf(stderr, "[W][%s] " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) ((void) 0)
+#define ESP_LOGD(tag, format, ...) ((void) 0)
+#define ESP_LOGV(tag, format, ...) ((void) 0)
+#define ESP_LOGVV(tag, format, ...) ((void) 0)
+#define ESP_LOGCONFIG(tag, format, ...) ((void) (tag))
+#define LOG_PIN(prefix, pin) ((void) 0)
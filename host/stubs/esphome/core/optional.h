@@ -0,0 +1,9 @@
+#pragma once
+
+// Host stand-in for ESPHome's optional.h
+
+#include <optional>
+
+namespace esphome {
+template<typename T> using optional = std::optional<T>;
+} // namespace esphome
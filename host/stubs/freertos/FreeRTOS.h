@@ -0,0 +1,23 @@
+#pragma once
+
+// Host stand-in for the parts of FreeRTOS wmbus_radio uses. Tasks are
+// threads with one notification counter each; a tick is a millisecond.
+
+#include <cstdint>
+
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+typedef uint32_t TickType_t;
+
+struct HostTask;
+typedef HostTask *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdFAIL 0
+#define pdPASS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t) (ms))
+#define portMAX_DELAY ((TickType_t) 0xFFFFFFFF)
+#define portYIELD_FROM_ISR(woken) ((void) (woken))
+#define tskNO_AFFINITY 0x7FFFFFFF
@@ -0,0 +1,77 @@
+#include "task.h"
+
+#include <pthread.h>
+#include <time.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+struct HostTask {
+  std::mutex mutex;
+  std::condition_variable cv;
+  uint32_t notifications{0};
+  clockid_t cpu_clock{};
+};
+
+// Task of the calling thread (threads not started by xTaskCreatePinnedToCore
+// get one on first use)
+static thread_local HostTask *current_task = nullptr;
+
+static HostTask *self() {
+  if (current_task == nullptr)
+    current_task = new HostTask();
+  return current_task;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stack_size, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core) {
+  auto *task = new HostTask();
+  if (handle != nullptr)
+    *handle = task;
+  std::thread thread([task, function, arg] {
+    current_task = task;
+    function(arg);
+  });
+  pthread_getcpuclockid(thread.native_handle(), &task->cpu_clock);
+  thread.detach();
+  return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait) {
+  HostTask *task = self();
+  std::unique_lock<std::mutex> lock(task->mutex);
+  const auto notified = [task] { return task->notifications > 0; };
+  if (ticks_to_wait == portMAX_DELAY)
+    task->cv.wait(lock, notified);
+  else if (!task->cv.wait_for(lock, std::chrono::milliseconds(ticks_to_wait), notified))
+    return 0;
+  const uint32_t value = task->notifications;
+  task->notifications = clear_on_exit ? 0 : value - 1;
+  return value;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+  {
+    std::lock_guard<std::mutex> lock(task->mutex);
+    task->notifications++;
+  }
+  task->cv.notify_one();
+  return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *higher_priority_task_woken) {
+  xTaskNotifyGive(task);
+  if (higher_priority_task_woken != nullptr)
+    *higher_priority_task_woken = pdFALSE;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) { return 0; }
+
+uint64_t host_task_cpu_ns(TaskHandle_t task) {
+  timespec ts{};
+  if (task == nullptr || clock_gettime(task->cpu_clock, &ts) != 0)
+    return 0;
+  return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
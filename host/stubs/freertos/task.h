@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+
+#include "FreeRTOS.h"
+
+// Starts a detached thread; core and priority are ignored
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stack_size, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core);
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *higher_priority_task_woken);
+
+// Unknown on a host: always 0
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+
+// Host only: CPU time the task's thread has used so far
+uint64_t host_task_cpu_ns(TaskHandle_t task);
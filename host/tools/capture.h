@@ -0,0 +1,141 @@
+#pragma once
+
+// Reads the capture formats accepted by the host tools, one packet per line:
+//  - raw packet hex as the transceiver delivered it, on its own or after
+//    "raw(hex)=" as in the DROPPED log lines
+//  - diagnostic events from diagnostic_topic with a "raw" field (also as
+//    printed by mosquitto_sub -v); events with "decoded" bytes are skipped
+//  - rtlwmbus lines (T1;1;1;<time>;<rssi>;;;0x<frame>). These frames are
+//    already decoded, so they are brought back to their on-air form first:
+//    format A CRCs added if missing, 3-of-6 coded for T1.
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "dll_crc.h"
+
+#include "frame_builder.h"
+
+namespace wmbus_host {
+
+using esphome::wmbus_radio::dll_crc_ok;
+using esphome::wmbus_radio::dll_size_format_a;
+using esphome::wmbus_radio::DllCrcResult;
+using esphome::wmbus_radio::strip_dll_crc_format_b;
+
+enum class CaptureLine { NONE, RAW, RTLWMBUS };
+
+inline int hex_value(char c) {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+// Hex digits (optionally after "0x") from `begin` up to the first non-hex
+// character, which `stop` is set to
+inline bool parse_hex(const char *begin, const char *end, std::vector<uint8_t> &out, const char **stop = nullptr) {
+  out.clear();
+  if (end - begin >= 2 && begin[0] == '0' && (begin[1] == 'x' || begin[1] == 'X'))
+    begin += 2;
+  const char *p = begin;
+  while (p < end && hex_value(*p) >= 0)
+    p++;
+  if (stop != nullptr)
+    *stop = p;
+  if (p == begin || (p - begin) % 2 != 0)
+    return false;
+  for (const char *q = begin; q < p; q += 2)
+    out.push_back((uint8_t) (hex_value(q[0]) << 4 | hex_value(q[1])));
+  return true;
+}
+
+// Value of "key":<number> in a JSON line, or `fallback`
+inline int json_int(const std::string &line, const char *key, int fallback) {
+  const size_t pos = line.find(key);
+  if (pos == std::string::npos)
+    return fallback;
+  return std::atoi(line.c_str() + pos + std::strlen(key));
+}
+
+inline bool is_format_b_with_crc(const std::vector<uint8_t> &frame) {
+  std::vector<uint8_t> copy = frame;
+  size_t len = copy.size();
+  return len == (size_t) copy[0] + 1 && strip_dll_crc_format_b(copy.data(), len) == DllCrcResult::OK;
+}
+
+// Decoded rtlwmbus frame (with or without DLL CRCs) back to on-air bytes
+inline bool rtlwmbus_to_raw(const std::string &mode, std::vector<uint8_t> frame, std::vector<uint8_t> &raw) {
+  if (frame.size() < 12 || (mode != "T1" && mode != "C1"))
+    return false;
+  const bool format_a = frame.size() == dll_size_format_a(frame[0]) && dll_crc_ok(frame.data(), 10);
+  const bool format_b = !format_a && is_format_b_with_crc(frame);
+  if (!format_a && !format_b)
+    frame = with_dll_crc(frame, FrameFormat::A);  // CRCs removed by the receiver
+  if (frame.empty())
+    return false;
+  // Bytes with CRCs are kept as they are, even if a later block is damaged
+  if (mode == "T1") {
+    raw.resize(esphome::wmbus_radio::encoded_size(frame.size()));
+    esphome::wmbus_radio::encode3of6(frame.data(), frame.size(), raw.data());
+  } else {
+    raw = {0x54, (uint8_t) (format_b ? 0x3D : 0xCD)};
+    raw.insert(raw.end(), frame.begin(), frame.end());
+  }
+  return true;
+}
+
+// Hash of the frame bytes in wmbus_replay --results files
+inline uint32_t fnv1a(const uint8_t *data, size_t len) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < len; i++)
+    hash = (hash ^ data[i]) * 16777619u;
+  return hash;
+}
+
+// Packet bytes and RSSI from one capture line (RSSI 0 if not recorded)
+inline CaptureLine parse_capture_line(const std::string &line, std::vector<uint8_t> &raw, int &rssi) {
+  rssi = 0;
+  const char *text = line.c_str();
+  const char *end = text + line.size();
+
+  size_t pos = line.find("\"raw\":\"");
+  if (pos != std::string::npos) {
+    rssi = json_int(line, "\"rssi\":", 0);
+    return parse_hex(text + pos + 7, end, raw) ? CaptureLine::RAW : CaptureLine::NONE;
+  }
+
+  // rtlwmbus: mode;1;1;time;rssi;;;0x<frame>
+  if (line.size() > 3 && line[2] == ';') {
+    std::vector<std::string> fields;
+    size_t start = 0;
+    for (size_t sep; (sep = line.find(';', start)) != std::string::npos; start = sep + 1)
+      fields.push_back(line.substr(start, sep - start));
+    fields.push_back(line.substr(start));
+    std::vector<uint8_t> frame;
+    if (fields.size() < 8 || !parse_hex(fields.back().c_str(), fields.back().c_str() + fields.back().size(), frame))
+      return CaptureLine::NONE;
+    rssi = std::atoi(fields[4].c_str());
+    return rtlwmbus_to_raw(fields[0], frame, raw) ? CaptureLine::RTLWMBUS : CaptureLine::NONE;
+  }
+
+  pos = line.find("raw(hex)=");
+  if (pos != std::string::npos)
+    return parse_hex(text + pos + 9, end, raw) ? CaptureLine::RAW : CaptureLine::NONE;
+
+  // Nothing but hex on the line
+  while (text < end && (*text == ' ' || *text == '\t'))
+    text++;
+  while (end > text && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r'))
+    end--;
+  const char *stop;
+  return parse_hex(text, end, raw, &stop) && stop == end ? CaptureLine::RAW : CaptureLine::NONE;
+}
+
+} // namespace wmbus_host
@@ -0,0 +1,186 @@
+// Writes synthetic on-air packets, one hex line each, built with the
+// encoder in frame_encoder.h: input for wmbus_replay, wmbus_sim --input and
+// decoder benchmarks.
+//
+//   wmbus_corpus [--count N] [--mode t1|c1|mix] [--format a|b|mix] [--size MIN:MAX]
+//                [--meters N] [--ber P] [--seed N] [--truth FILE] [OUTPUT]
+//
+// Without OUTPUT the packets go to stdout. --ber flips bits after encoding,
+// as noise on air would. --truth writes the results wmbus_replay --results
+// would give for OUTPUT if every packet decoded to the frame it was built
+// from, so that
+//
+//   wmbus_corpus --ber 1e-4 --truth truth.tsv corpus.txt
+//   wmbus_replay --results results.tsv corpus.txt
+//   wmbus_replay --diff truth.tsv results.tsv
+//
+// shows what the bit errors cost (replay the corpus under the same name).
+//
+// The first T1 format B frame is one whose first block also carries a valid
+// format A CRC (see make_format_a_lookalike), so every corpus with such
+// frames checks that the decoder tells the formats apart.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "frame_encoder.h"
+#include "link_mode.h"
+#include "packet.h"
+
+#include "capture.h"
+#include "frame_builder.h"
+
+using namespace esphome::wmbus_radio;
+using namespace wmbus_host;
+
+namespace {
+
+struct Options {
+  uint64_t count{100000};
+  const char *mode{"mix"};
+  const char *format{"mix"};
+  size_t min_size{40};
+  size_t max_size{100};
+  uint32_t meters{200};
+  double ber{0};
+  uint32_t seed{1};
+  const char *truth{nullptr};
+  const char *output{nullptr};
+};
+
+bool parse_range(const char *text, size_t &min, size_t &max) {
+  char *end;
+  min = std::strtoul(text, &end, 10);
+  if (*end != ':')
+    return false;
+  max = std::strtoul(end + 1, &end, 10);
+  return *end == '\0' && min <= max;
+}
+
+bool one_of(const char *value, const char *a, const char *b, const char *c) {
+  return std::strcmp(value, a) == 0 || std::strcmp(value, b) == 0 || std::strcmp(value, c) == 0;
+}
+
+bool parse_options(int argc, char **argv, Options &options) {
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    if (arg[0] != '-' || arg[1] == '\0') {
+      if (options.output != nullptr)
+        return false;
+      options.output = arg;
+      continue;
+    }
+    if (i + 1 >= argc)
+      return false;
+    const char *value = argv[++i];
+    if (std::strcmp(arg, "--count") == 0) {
+      options.count = std::strtoull(value, nullptr, 10);
+    } else if (std::strcmp(arg, "--mode") == 0) {
+      options.mode = value;
+      if (!one_of(value, "t1", "c1", "mix"))
+        return false;
+    } else if (std::strcmp(arg, "--format") == 0) {
+      options.format = value;
+      if (!one_of(value, "a", "b", "mix"))
+        return false;
+    } else if (std::strcmp(arg, "--size") == 0) {
+      // Room for the meter ID and frame number, and for the format B L-field
+      if (!parse_range(value, options.min_size, options.max_size) || options.min_size < 20 ||
+          options.max_size > max_frame_size(FrameFormat::B))
+        return false;
+    } else if (std::strcmp(arg, "--meters") == 0) {
+      options.meters = std::max<uint32_t>(std::strtoul(value, nullptr, 10), 1);
+    } else if (std::strcmp(arg, "--ber") == 0) {
+      options.ber = std::atof(value);
+    } else if (std::strcmp(arg, "--seed") == 0) {
+      options.seed = std::strtoul(value, nullptr, 10);
+    } else if (std::strcmp(arg, "--truth") == 0) {
+      options.truth = value;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  Options options;
+  if (!parse_options(argc, argv, options)) {
+    std::fprintf(stderr,
+                 "Usage: %s [--count N] [--mode t1|c1|mix] [--format a|b|mix] [--size MIN:MAX]\n"
+                 "       [--meters N] [--ber P] [--seed N] [--truth FILE] [OUTPUT]\n",
+                 argv[0]);
+    return 2;
+  }
+
+  std::FILE *out = stdout;
+  if (options.output != nullptr && (out = std::fopen(options.output, "w")) == nullptr) {
+    std::fprintf(stderr, "Cannot write %s\n", options.output);
+    return 2;
+  }
+  std::FILE *truth = nullptr;
+  if (options.truth != nullptr && (truth = std::fopen(options.truth, "w")) == nullptr) {
+    std::fprintf(stderr, "Cannot write %s\n", options.truth);
+    return 2;
+  }
+  // wmbus_replay names sources after the capture path, "stdin" for stdout here
+  const char *source = options.output != nullptr ? options.output : "stdin";
+
+  std::mt19937 random(options.seed);
+  std::uniform_int_distribution<size_t> size(options.min_size, options.max_size);
+  std::uniform_int_distribution<uint32_t> meter(0, options.meters - 1);
+  std::uniform_int_distribution<int> coin(0, 1);
+  uint32_t bit_error_state = options.seed;
+  uint64_t flipped = 0, damaged = 0;
+  bool lookalike_done = false;
+  uint8_t packet[PACKET_CAPACITY];
+  std::vector<char> line(2 * PACKET_CAPACITY + 2);
+
+  for (uint64_t n = 0; n < options.count; n++) {
+    auto frame = make_meter_frame(size(random), meter(random), (uint32_t) n);
+    const LinkMode mode = std::strcmp(options.mode, "t1") == 0   ? LinkMode::T1
+                          : std::strcmp(options.mode, "c1") == 0 ? LinkMode::C1
+                          : coin(random)                         ? LinkMode::C1
+                                                                 : LinkMode::T1;
+    const FrameFormat format = std::strcmp(options.format, "a") == 0   ? FrameFormat::A
+                               : std::strcmp(options.format, "b") == 0 ? FrameFormat::B
+                               : coin(random)                          ? FrameFormat::B
+                                                                       : FrameFormat::A;
+    if (mode == LinkMode::T1 && format == FrameFormat::B && !lookalike_done) {
+      make_format_a_lookalike(frame);
+      lookalike_done = true;
+    }
+    const size_t len = encode_packet(frame.data(), frame.size(), mode, format, packet, sizeof(packet));
+    const size_t errors = inject_bit_errors(packet, len, options.ber, bit_error_state);
+    flipped += errors;
+    damaged += errors > 0;
+
+    static const char *hex = "0123456789abcdef";
+    for (size_t i = 0; i < len; i++) {
+      line[2 * i] = hex[packet[i] >> 4];
+      line[2 * i + 1] = hex[packet[i] & 0x0F];
+    }
+    line[2 * len] = '\n';
+    std::fwrite(line.data(), 1, 2 * len + 1, out);
+
+    if (truth != nullptr)
+      std::fprintf(truth, "%s:%llu\tok\t%s\t%s\t%zu\t%08x\n", source, (unsigned long long) n + 1,
+                   link_mode_name(mode), format == FrameFormat::A ? "A" : "B", frame.size(),
+                   (unsigned) fnv1a(frame.data(), frame.size()));
+  }
+
+  if (out != stdout)
+    std::fclose(out);
+  if (truth != nullptr)
+    std::fclose(truth);
+  if (options.ber > 0)
+    std::fprintf(stderr, "%llu packets, %llu with bit errors (%llu bits flipped)\n",
+                 (unsigned long long) options.count, (unsigned long long) damaged, (unsigned long long) flipped);
+  return 0;
+}
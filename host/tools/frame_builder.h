@@ -0,0 +1,80 @@
+#pragma once
+
+// Synthetic frames for the host tools, and std::vector wrappers around
+// frame_encoder.h, which turns them into on-air packets.
+
+#include <cstddef>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "decode3of6.h"
+#include "dll_crc.h"
+#include "frame_encoder.h"
+
+namespace wmbus_host {
+
+using esphome::wmbus_radio::FrameFormat;
+using esphome::wmbus_radio::LinkMode;
+
+// L, C, M, ID, version, type, CI 0x7A with ACC/status/config, then filler
+inline std::vector<uint8_t> make_frame(size_t size, uint32_t seed) {
+  std::vector<uint8_t> frame = {(uint8_t) (size - 1), 0x44, 0x2D, 0x2C, 0x78, 0x56, 0x34, 0x12, 0x1B, 0x07,
+                                0x7A, (uint8_t) seed, 0x00, 0x00, 0x00};
+  uint32_t state = seed * 2654435761u + 1;
+  while (frame.size() < size) {
+    state = state * 1103515245u + 12345u;
+    frame.push_back((uint8_t) (state >> 16));
+  }
+  frame.resize(size);
+  return frame;
+}
+
+// make_frame() from meter `id`, with `number` in bytes 15-18 so that every
+// frame is different; `size` must be at least 19
+inline std::vector<uint8_t> make_meter_frame(size_t size, uint32_t id, uint32_t number) {
+  auto frame = make_frame(size, number);
+  for (int i = 0; i < 4; i++) {
+    frame[4 + i] = (uint8_t) (id >> (8 * i));
+    frame[15 + i] = (uint8_t) (number >> (8 * i));
+  }
+  return frame;
+}
+
+// Make `frame` a format B frame whose first 10 bytes on air carry a valid
+// format A block CRC, by changing the version and device type bytes (8-9).
+// One in 65536 real frames looks like this; a T1 receiver must not take it
+// for format A.
+inline void make_format_a_lookalike(std::vector<uint8_t> &frame) {
+  using namespace esphome::wmbus_radio;
+  uint8_t block[10];
+  std::copy(frame.begin(), frame.begin() + 10, block);
+  block[0] = (uint8_t) (dll_size_format_b(frame.size()) - 1);  // the L-field on air
+  for (uint32_t v = 0; v <= 0xFFFF; v++) {
+    block[8] = (uint8_t) (v >> 8);
+    block[9] = (uint8_t) v;
+    if (crc16_en13757(block, 10) == (uint16_t) (frame[10] << 8 | frame[11])) {
+      frame[8] = block[8];
+      frame[9] = block[9];
+      return;
+    }
+  }
+}
+
+// `frame` without CRCs (L-field first), with them; empty if it does not fit
+inline std::vector<uint8_t> with_dll_crc(const std::vector<uint8_t> &frame, FrameFormat format) {
+  using namespace esphome::wmbus_radio;
+  std::vector<uint8_t> out(dll_size_format_a(0xFF));  // the most CRCs any frame has
+  out.resize(format == FrameFormat::A ? insert_dll_crc_format_a(frame.data(), frame.size(), out.data())
+                                      : insert_dll_crc_format_b(frame.data(), frame.size(), out.data()));
+  return out;
+}
+
+// On-air packet of `frame` (without CRCs); empty if it does not fit
+inline std::vector<uint8_t> encode_packet(const std::vector<uint8_t> &frame, LinkMode mode, FrameFormat format) {
+  std::vector<uint8_t> out(esphome::wmbus_radio::encoded_packet_size(frame.size(), mode, format));
+  out.resize(esphome::wmbus_radio::encode_packet(frame.data(), frame.size(), mode, format, out.data(), out.size()));
+  return out;
+}
+
+} // namespace wmbus_host
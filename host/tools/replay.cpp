@@ -0,0 +1,248 @@
+// Replays captured packets through Packet::convert_to_frame(), the code the
+// firmware runs, and reports the decode yield and throughput.
+//
+//   wmbus_replay [--results FILE] CAPTURE...   (CAPTURE "-" reads stdin)
+//   wmbus_replay --diff RESULTS_A RESULTS_B
+//
+// A capture holds one packet per line: raw packet hex, diagnostic events or
+// rtlwmbus lines (see capture.h). Anything else is counted as skipped.
+//
+// --results writes one line per packet: source, result, link mode, frame
+// format, frame length and an FNV-1a hash of the frame bytes. --diff
+// compares the results of two builds run on the same captures.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "packet.h"
+
+#include "capture.h"
+
+using namespace esphome::wmbus_radio;
+using namespace wmbus_host;
+
+namespace {
+
+struct Stats {
+  uint64_t lines{0};
+  uint64_t skipped{0};
+  uint64_t raw{0};
+  uint64_t rtlwmbus{0};
+  uint64_t bytes{0};
+  uint64_t decode_ns{0};
+  uint64_t results[(size_t) DropReason::COUNT]{};
+  // Decoded frames by link mode and format
+  std::map<std::string, uint64_t> decoded;
+};
+
+// Packet bytes and RSSI from one capture line; false if it holds none
+bool parse_line(const std::string &line, std::vector<uint8_t> &raw, int &rssi, Stats &stats) {
+  switch (parse_capture_line(line, raw, rssi)) {
+    case CaptureLine::RAW:
+      stats.raw++;
+      return true;
+    case CaptureLine::RTLWMBUS:
+      stats.rtlwmbus++;
+      return true;
+    default:
+      return false;
+  }
+}
+
+void replay_stream(std::istream &in, const std::string &name, Stats &stats, std::FILE *results) {
+  static Packet packet;
+  std::string line;
+  std::vector<uint8_t> raw;
+  uint64_t line_no = 0;
+  while (std::getline(in, line)) {
+    line_no++;
+    stats.lines++;
+    int rssi;
+    if (!parse_line(line, raw, rssi, stats)) {
+      stats.skipped++;
+      continue;
+    }
+    // The radio stops reading there as well
+    if (raw.size() > PACKET_CAPACITY)
+      raw.resize(PACKET_CAPACITY);
+
+    const auto start = std::chrono::steady_clock::now();
+    packet.reset();
+    std::memcpy(packet.append_space(raw.size()), raw.data(), raw.size());
+    packet.set_rssi((int8_t) rssi);
+    auto frame = packet.convert_to_frame();
+    stats.decode_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start)
+                           .count();
+    stats.bytes += raw.size();
+    stats.results[(size_t) packet.drop_reason()]++;
+
+    const char *result = frame ? "ok" : drop_reason_name(packet.drop_reason());
+    const char *mode = link_mode_name(packet.get_link_mode());
+    if (frame)
+      stats.decoded[std::string(mode).append("/").append(frame->format())]++;
+    if (results != nullptr) {
+      const std::string_view format = frame ? frame->format() : "-";
+      std::fprintf(results, "%s:%llu\t%s\t%s\t%.*s\t%zu\t%08x\n", name.c_str(), (unsigned long long) line_no,
+                   result, mode, (int) format.size(), format.data(), frame ? frame->size() : 0,
+                   frame ? (unsigned) fnv1a(frame->data(), frame->size()) : 0u);
+    }
+  }
+}
+
+void print_report(const Stats &stats) {
+  const uint64_t packets = stats.lines - stats.skipped;
+  std::printf("Input:  %llu lines, %llu packets (%llu raw, %llu rtlwmbus), %llu skipped\n",
+              (unsigned long long) stats.lines, (unsigned long long) packets, (unsigned long long) stats.raw,
+              (unsigned long long) stats.rtlwmbus, (unsigned long long) stats.skipped);
+  if (packets == 0)
+    return;
+  const double seconds = stats.decode_ns / 1e9;
+  std::printf("Decode: %.3f s, %.0f packets/s, %.1f MB/s, %.0f ns/packet\n", seconds,
+              seconds > 0 ? packets / seconds : 0.0, seconds > 0 ? stats.bytes / seconds / 1e6 : 0.0,
+              (double) stats.decode_ns / packets);
+  std::printf("\n%-22s %12s %8s\n", "result", "packets", "%");
+  for (size_t i = 0; i < (size_t) DropReason::COUNT; i++) {
+    if (stats.results[i] == 0 && i != 0)
+      continue;
+    std::printf("%-22s %12llu %8.2f\n", i == 0 ? "ok" : drop_reason_name((DropReason) i),
+                (unsigned long long) stats.results[i], 100.0 * stats.results[i] / packets);
+    if (i == 0) {
+      for (const auto &entry : stats.decoded)
+        std::printf("  %-20s %12llu %8.2f\n", entry.first.c_str(), (unsigned long long) entry.second,
+                    100.0 * entry.second / packets);
+    }
+  }
+}
+
+struct ResultLine {
+  std::string source;
+  std::string result;
+  // Mode, format, length and hash: the frame as published
+  std::string frame;
+};
+
+bool read_result(std::istream &in, ResultLine &out) {
+  std::string line;
+  if (!std::getline(in, line))
+    return false;
+  const size_t first = line.find('\t');
+  const size_t second = line.find('\t', first + 1);
+  out.source = line.substr(0, first);
+  out.result = line.substr(first + 1, second - first - 1);
+  out.frame = second == std::string::npos ? "" : line.substr(second + 1);
+  for (char &c : out.frame)
+    if (c == '\t')
+      c = ' ';
+  return true;
+}
+
+int diff_results(const char *path_a, const char *path_b) {
+  std::ifstream a(path_a), b(path_b);
+  if (!a || !b) {
+    std::fprintf(stderr, "Cannot open %s\n", !a ? path_a : path_b);
+    return 2;
+  }
+  std::map<std::string, uint64_t> transitions;
+  uint64_t packets = 0, changed = 0, frames_changed = 0;
+  std::vector<std::string> examples;
+  ResultLine left, right;
+  while (true) {
+    const bool has_left = read_result(a, left);
+    const bool has_right = read_result(b, right);
+    if (!has_left && !has_right)
+      break;
+    if (has_left != has_right || left.source != right.source) {
+      std::fprintf(stderr, "The results are not from the same captures (at %s)\n",
+                   has_left ? left.source.c_str() : right.source.c_str());
+      return 2;
+    }
+    packets++;
+    if (left.result != right.result) {
+      changed++;
+      transitions[left.result + " -> " + right.result]++;
+    } else if (left.frame != right.frame) {
+      frames_changed++;
+    } else {
+      continue;
+    }
+    if (examples.size() < 20)
+      examples.push_back(left.source + ": " + left.result + " " + left.frame + " -> " + right.result + " " +
+                         right.frame);
+  }
+
+  std::printf("%llu packets, %llu with a different result, %llu decoded to different bytes\n",
+              (unsigned long long) packets, (unsigned long long) changed, (unsigned long long) frames_changed);
+  for (const auto &entry : transitions)
+    std::printf("  %-44s %10llu\n", entry.first.c_str(), (unsigned long long) entry.second);
+  if (!examples.empty()) {
+    std::printf("\nFirst differences:\n");
+    for (const auto &example : examples)
+      std::printf("  %s\n", example.c_str());
+  }
+  return changed || frames_changed ? 1 : 0;
+}
+
+int usage(const char *name) {
+  std::fprintf(stderr,
+               "Usage: %s [--results FILE] CAPTURE...\n"
+               "       %s --diff RESULTS_A RESULTS_B\n",
+               name, name);
+  return 2;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const char *results_path = nullptr;
+  std::vector<const char *> captures;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--diff") == 0) {
+      if (argc != i + 3)
+        return usage(argv[0]);
+      return diff_results(argv[i + 1], argv[i + 2]);
+    }
+    if (std::strcmp(argv[i], "--results") == 0 && i + 1 < argc) {
+      results_path = argv[++i];
+    } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+      return usage(argv[0]);
+    } else {
+      captures.push_back(argv[i]);
+    }
+  }
+  if (captures.empty())
+    return usage(argv[0]);
+
+  std::FILE *results = nullptr;
+  if (results_path != nullptr && (results = std::fopen(results_path, "w")) == nullptr) {
+    std::fprintf(stderr, "Cannot write %s\n", results_path);
+    return 2;
+  }
+
+  Stats stats;
+  for (const char *capture : captures) {
+    if (std::strcmp(capture, "-") == 0) {
+      replay_stream(std::cin, "stdin", stats, results);
+      continue;
+    }
+    std::ifstream in(capture);
+    if (!in) {
+      std::fprintf(stderr, "Cannot open %s\n", capture);
+      return 2;
+    }
+    replay_stream(in, capture, stats, results);
+  }
+  if (results != nullptr)
+    std::fclose(results);
+
+  print_report(stats);
+  return 0;
+}